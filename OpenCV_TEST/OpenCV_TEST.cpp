@@ -11,6 +11,43 @@
 #include <random>      // std::mt19937, std::uniform_int_distribution
 #include <limits>      // std::numeric_limits
 #include <sstream>     // std::stringstream (JSON 빌드용)
+#include <cstdint>     // uint64_t (타이머 휠 틱)
+#include <cstdio>      // std::remove (벤치마크 임시 파일)
+#include <cstring>     // std::memcmp, std::memcpy (바이너리 맵 파일)
+#include <fstream>     // std::ifstream, std::ofstream (맵 파일 변환)
+#include <string_view> // std::string_view (매핑된 문자열 풀)
+#include <new>         // placement new (맵 아레나)
+#include <type_traits> // std::is_trivially_destructible
+#include <atomic>      // std::atomic (병렬 경로 표)
+#include <memory>      // std::shared_ptr (맵 스냅샷)
+#include <array>       // std::array (기본 맵 거리 표)
+#include <mutex>       // std::mutex, std::condition_variable (스레드 풀)
+#include <condition_variable>
+#include <functional>  // std::function
+#include <unordered_set> // 맵 생성 시 중복 도로 확인
+#include <unordered_map> // 경로 캐시 키 -> 슬롯
+#include <deque>       // 목적지 트리 슬롯 (주소가 바뀌지 않아야 함)
+#include <cstdlib>     // std::atoi, std::strtoull (도구 모드 인자)
+
+// 바이너리 맵 파일 메모리 매핑 (Windows / POSIX)
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <intrin.h>    // _BitScanReverse64 (radix heap)
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 벤치마크 캐시 미스 측정 (Linux perf 이벤트)
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 // [복원] SQLite3 헤더
 #include "sqlite3.h"
@@ -49,6 +86,16 @@ void sendControlToRasPi(int handle, int pedal) {
     // cout << "[COMM STUB -> RPI]: Handle=" << handle << ", Pedal=" << pedal << endl;
 }
 
+/**
+ * @brief [스텁] 라즈베리파이(RC카)로 신호등 상태 변경을 전송합니다. (담당: 성예찬)
+ * @param nodeId 교차로 노드 ID
+ * @param isGreen 변경된 신호 (true: 녹색, false: 적색)
+ */
+void sendLightStateToRasPi(int nodeId, bool isGreen) {
+    // 이 함수는 '성예찬' 이 구현할 실제 통신 코드로 대체됩니다.
+    // cout << "[COMM STUB -> RPI]: Light " << nodeId << (isGreen ? " GREEN" : " RED") << endl;
+}
+
 
 // =================================================================
 // 0. 위반 유형 Enum
@@ -233,8 +280,78 @@ vector<Row> db_list(int offset, int limit, int& totalCount) {
 // 3. 게임 월드 (맵) 구현 (그래프 기반)
 // =================================================================
 
-// 난수 생성기
-std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+// 난수 생성기 (스레드마다 따로 두어 여러 게임 세션을 동시에 진행해도 안전)
+thread_local std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+
+/**
+ * @brief 단조 증가(monotonic) 메모리 아레나 (맵의 노드/엣지/이름 문자열 전용)
+ *
+ * 큰 블록을 잡아 두고 앞에서부터 잘라 쓰기만 하며, 개별 해제는 하지 않는다.
+ * 블록 크기가 두 배씩 커지므로 블록 수는 O(log n) 이고, 해제는 블록만 한꺼번에 반환한다.
+ * 소멸자가 필요 없는(trivially destructible) 객체만 담을 수 있다.
+ */
+class MonotonicArena {
+public:
+    explicit MonotonicArena(size_t firstBlockSize = 4096) : nextBlockSize(firstBlockSize) {}
+    ~MonotonicArena() { release(); }
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (!current || offset + bytes > capacity) {
+            addBlock(bytes + align);
+            offset = 0;
+        }
+        used = offset + bytes;
+        totalUsed += bytes;
+        return current + offset;
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    std::string_view copyString(std::string_view text) {
+        char* dst = static_cast<char*>(allocate(text.size(), 1));
+        if (!text.empty()) std::memcpy(dst, text.data(), text.size());
+        return std::string_view(dst, text.size());
+    }
+
+    // 앞으로 bytes 만큼은 한 블록에 연속으로 놓이도록 미리 확보
+    void reserve(size_t bytes) {
+        if (!current || capacity - used < bytes) addBlock(bytes);
+    }
+
+    void release() {
+        for (char* block : blocks) ::operator delete(block);
+        blocks.clear();
+        current = nullptr;
+        capacity = used = totalUsed = 0;
+    }
+
+    size_t bytesUsed() const { return totalUsed; }
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    vector<char*> blocks;
+    char* current = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t totalUsed = 0;
+    size_t nextBlockSize;
+
+    void addBlock(size_t minBytes) {
+        size_t size = std::max(nextBlockSize, minBytes);
+        current = static_cast<char*>(::operator new(size));
+        blocks.push_back(current);
+        capacity = size;
+        used = 0;
+        nextBlockSize = size * 2;
+    }
+};
 
 enum NodeType {
     STORE,        // 가게 (4개)
@@ -245,183 +362,3394 @@ enum NodeType {
 
 struct Node {
     int id;
-    string name;
-    NodeType type;
-    bool lightIsGreen; // 신호등 상태 (교차로인 경우)
+    std::string_view name; // Map 아레나에 저장된 이름
+    NodeType type; // 교차로 신호의 현재 상태는 세션마다 다르므로 MapSession 에 있음
 
-    Node(int i, string n, NodeType t)
-        : id(i), name(n), type(t), lightIsGreen(true) {
+    Node(int i, std::string_view n, NodeType t)
+        : id(i), name(n), type(t) {
     }
 };
 
 struct Edge {
+    int id;            // Map::edges 내 인덱스 (가중치 배열 인덱스로 사용)
     Node* from;
     Node* to;
     double length;     // km
     double speedLimit; // km/h
     bool isOneWay;
 
-    Edge(Node* f, Node* t, double l, double sl, bool ow = false)
-        : from(f), to(t), length(l), speedLimit(sl), isOneWay(ow) {
+    Edge(int i, Node* f, Node* t, double l, double sl, bool ow = false)
+        : id(i), from(f), to(t), length(l), speedLimit(sl), isOneWay(ow) {
+    }
+};
+
+// 경로 비용 함수 (findPath 가 최소화할 엣지 가중치 종류)
+enum RouteMetric {
+    METRIC_DISTANCE,    // 거리 (km)
+    METRIC_FREE_FLOW,   // 자유 주행 시간 (초) = length / speedLimit
+    METRIC_LIGHT_AWARE, // 자유 주행 시간 + 교차로 진입 시 평균 신호 대기 시간 (초)
+    METRIC_COUNT
+};
+
+/**
+ * @brief 교차로 신호 주기 모델 (시각 단위: 초, 기준: MapSession::signalEpoch)
+ */
+struct SignalPlan {
+    double cycleSec = 60.0;  // 신호 주기
+    double offsetSec = 0.0;  // 주기 시작 오프셋 (교차로 간 연동용)
+    double greenRatio = 0.5; // 주기 중 녹색 신호 비율 (green split)
+
+    double greenSec() const { return cycleSec * greenRatio; }
+
+    // t 시점의 주기 내 위치 [0, cycleSec)
+    double phaseAt(double t) const {
+        double p = std::fmod(t - offsetSec, cycleSec);
+        return p < 0 ? p + cycleSec : p;
+    }
+
+    bool isGreenAt(double t) const { return phaseAt(t) < greenSec(); }
+
+    // t 시점에 도착했을 때 녹색 신호까지 기다려야 하는 시간
+    double waitAt(double t) const {
+        double p = phaseAt(t);
+        return p < greenSec() ? 0.0 : cycleSec - p;
+    }
+
+    // t 시점 이후 처음으로 신호가 바뀌는 시각
+    double nextChangeAt(double t) const {
+        double p = phaseAt(t);
+        return p < greenSec() ? t + (greenSec() - p) : t + (cycleSec - p);
+    }
+
+    // 임의 시각 도착 시 평균 대기 시간 (적색 구간 r 에 대해 r^2 / 2C)
+    double expectedWait() const {
+        double red = cycleSec - greenSec();
+        return red * red / (2.0 * cycleSec);
+    }
+};
+
+/**
+ * @brief 교차로 하나의 최근 신호 변경 기록 (고정 크기 링 버퍼, 가장 오래된 기록부터 덮어씀)
+ *
+ * 늦게 전달된 NFC 이벤트를 "그 시각에 실제로 켜져 있던 신호" 로 판정하는 데 사용.
+ * 기본 주기(60초, 녹색 50%)면 8개로 최근 4주기를 덮는다.
+ */
+struct SignalHistory {
+    static const int CAPACITY = 8;
+    double changedAt[CAPACITY] = {}; // 신호가 바뀐 시각 (signalEpoch 기준 초)
+    bool green[CAPACITY] = {};
+    int head = 0;  // 다음에 쓸 위치
+    int count = 0;
+
+    void record(double t, bool isGreen) {
+        changedAt[head] = t;
+        green[head] = isGreen;
+        head = (head + 1) % CAPACITY;
+        if (count < CAPACITY) ++count;
+    }
+
+    // t 시점의 신호. 기록이 모두 t 이후면 false (기록 범위 밖)
+    bool stateAt(double t, bool& isGreen) const {
+        for (int i = 1; i <= count; ++i) {
+            int k = (head - i + CAPACITY) % CAPACITY;
+            if (changedAt[k] <= t) {
+                isGreen = green[k];
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief 계층형 타이머 휠 (신호 변경 스케줄링용)
+ *
+ * 시간을 틱 단위로 나누고, 가까운 타이머는 0단계 휠에, 먼 타이머는 상위 단계 휠에 둔다.
+ * 상위 휠의 슬롯 차례가 오면 그 슬롯의 타이머를 하위 휠로 내려보낸다(cascade).
+ * 한 틱의 처리 비용은 그 틱에 만료되는 타이머 수에만 비례한다.
+ */
+class TimerWheel {
+public:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS; // 단계당 64 슬롯 -> 64^4 틱 범위
+
+    struct Timer {
+        uint64_t expireTick;
+        int id;
+    };
+
+    uint64_t currentTick = 0; // 마지막으로 처리한 틱
+
+    // expireTick 에 id 타이머 등록 (이미 지난 틱이면 다음 틱에 만료)
+    void schedule(int id, uint64_t expireTick) {
+        insert({ std::max(expireTick, currentTick + 1), id });
+    }
+
+    // targetTick 까지 진행하며 만료된 타이머마다 onExpire(id, tick) 호출
+    // (콜백 안에서 schedule 을 다시 호출해도 안전함)
+    template <typename F>
+    void advance(uint64_t targetTick, F onExpire) {
+        while (currentTick < targetTick) {
+            ++currentTick;
+            for (int level = LEVELS - 1; level > 0; --level) {
+                uint64_t lowMask = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+                if ((currentTick & lowMask) == 0) cascade(level);
+            }
+            // 슬롯과 due 버퍼를 맞바꿔 처리 (버퍼 용량을 유지해서 틱마다 할당하지 않음)
+            due.swap(wheels[0][currentTick & (SLOTS - 1)]);
+            for (const Timer& t : due) {
+                if (t.expireTick > currentTick) insert(t); // 범위를 넘어 잘린 타이머
+                else onExpire(t.id, currentTick);
+            }
+            due.clear();
+        }
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(*this) + (due.capacity() + moved.capacity()) * sizeof(Timer);
+        for (const auto& level : wheels) {
+            for (const vector<Timer>& slot : level) bytes += slot.capacity() * sizeof(Timer);
+        }
+        return bytes;
+    }
+
+private:
+    vector<Timer> wheels[LEVELS][SLOTS];
+    vector<Timer> due, moved; // advance / cascade 처리용 (슬롯과 맞바꿔 재사용)
+
+    void insert(const Timer& t) {
+        uint64_t delta = t.expireTick - currentTick;
+        uint64_t placeTick = t.expireTick;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) ++level;
+        uint64_t range = uint64_t(1) << (SLOT_BITS * LEVELS);
+        if (delta >= range) placeTick = currentTick + range - 1;
+        wheels[level][(placeTick >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(t);
+    }
+
+    void cascade(int level) {
+        moved.swap(wheels[level][(currentTick >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+        for (const Timer& t : moved) insert(t);
+        moved.clear();
+    }
+};
+
+// =================================================================
+// 3-1. 바이너리 맵 파일 (.dmap) - 파싱 없이 메모리 매핑해서 그대로 사용
+// =================================================================
+//
+// 파일 구조 (리틀 엔디언, 각 구역은 8바이트 정렬)
+//   [MapFileHeader][MapFileNode x N][MapFileEdge x M][MapFileTag x T]
+//   [outStart uint32 x (N+1)][outEdges uint32 x M][문자열 풀]
+// - 엣지: Map::edges 와 같은 단방향 엣지 목록 (양방향 도로는 2개)
+// - outStart/outEdges: 노드별 출발 엣지 인덱스 (CSR 인접 리스트)
+// - NFC 태그 표: 태그 문자열 순으로 정렬 -> 이진 탐색으로 조회
+
+const uint32_t MAP_FILE_VERSION = 1;
+const char MAP_FILE_MAGIC[8] = { 'D', 'L', 'V', 'M', 'A', 'P', '\0', '\0' };
+
+struct MapFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t tagCount;
+    uint64_t fileSize;
+    uint64_t nodesOffset;
+    uint64_t edgesOffset;
+    uint64_t tagsOffset;
+    uint64_t outStartOffset;
+    uint64_t outEdgesOffset;
+    uint64_t stringPoolOffset;
+    uint64_t stringPoolSize;
+};
+
+struct MapFileNode {
+    uint32_t nameOffset; // 문자열 풀 내 위치
+    uint32_t nameLength;
+    uint32_t type;       // NodeType
+    uint32_t reserved;
+    double signalCycleSec;   // 교차로 신호 주기 (SignalPlan)
+    double signalOffsetSec;
+    double signalGreenRatio;
+};
+
+struct MapFileEdge {
+    uint32_t from;
+    uint32_t to;
+    double length;     // km
+    double speedLimit; // km/h
+    uint32_t isOneWay;
+    uint32_t reserved;
+};
+
+struct MapFileTag {
+    uint32_t tagOffset; // 문자열 풀 내 위치
+    uint32_t tagLength;
+    uint32_t nodeId;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(MapFileHeader) == 88, "MapFileHeader layout");
+static_assert(sizeof(MapFileNode) == 40, "MapFileNode layout");
+static_assert(sizeof(MapFileEdge) == 32, "MapFileEdge layout");
+static_assert(sizeof(MapFileTag) == 16, "MapFileTag layout");
+
+/**
+ * @brief 바이너리 맵 파일 읽기 전용 뷰 (mmap / MapViewOfFile)
+ *
+ * open() 은 헤더, 구역 범위, 레코드(노드 종류, 엣지 끝점, 인접 배열, 태그 노드, 문자열 범위)를
+ * 한 번 확인하고, 이후 노드/엣지/태그는 매핑된 메모리를 그대로 가리킨다.
+ * 잘리거나 손상된 파일은 open() 에서 거부되므로 조회 함수는 범위를 다시 확인하지 않는다.
+ */
+class MapFile {
+public:
+    MapFile() {}
+    ~MapFile() { close(); }
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize)) {
+            std::cerr << "[Map Error] Cannot open map file: " << path << endl;
+            close();
+            return false;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle) base = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        size = (size_t)fileSize.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::cerr << "[Map Error] Cannot open map file: " << path << endl;
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        size = (size_t)st.st_size;
+        void* p = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (p != MAP_FAILED) base = static_cast<const char*>(p);
+#endif
+        if (!base) {
+            std::cerr << "[Map Error] Cannot map map file: " << path << endl;
+            close();
+            return false;
+        }
+        if (!validate()) {
+            std::cerr << "[Map Error] Invalid or incompatible map file: " << path << endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (base) UnmapViewOfFile(base);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap(const_cast<char*>(base), size);
+#endif
+        base = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    const MapFileHeader& header() const { return *reinterpret_cast<const MapFileHeader*>(base); }
+    uint32_t nodeCount() const { return header().nodeCount; }
+    uint32_t edgeCount() const { return header().edgeCount; }
+    uint32_t tagCount() const { return header().tagCount; }
+    const MapFileNode* nodes() const { return section<MapFileNode>(header().nodesOffset); }
+    const MapFileEdge* edges() const { return section<MapFileEdge>(header().edgesOffset); }
+    const MapFileTag* tags() const { return section<MapFileTag>(header().tagsOffset); }
+    const uint32_t* outStart() const { return section<uint32_t>(header().outStartOffset); }
+    const uint32_t* outEdges() const { return section<uint32_t>(header().outEdgesOffset); }
+
+    std::string_view poolString(uint32_t offset, uint32_t length) const {
+        return std::string_view(base + header().stringPoolOffset + offset, length);
+    }
+    std::string_view nodeName(uint32_t nodeId) const {
+        return poolString(nodes()[nodeId].nameOffset, nodes()[nodeId].nameLength);
+    }
+    std::string_view tagName(uint32_t index) const {
+        return poolString(tags()[index].tagOffset, tags()[index].tagLength);
+    }
+
+    // NFC 태그 -> 노드 ID (없으면 -1)
+    int findNodeByTag(std::string_view tagId) const {
+        uint32_t lo = 0, hi = tagCount();
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (tagName(mid) < tagId) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < tagCount() && tagName(lo) == tagId) return (int)tags()[lo].nodeId;
+        return -1;
+    }
+
+    // 매핑된 데이터 위에서 바로 거리 기준 최단 경로 (엣지 인덱스 목록, 없으면 빈 목록)
+    vector<uint32_t> findPath(uint32_t start, uint32_t end) const {
+        if (start >= nodeCount() || end >= nodeCount()) {
+            std::cerr << "[Map Error] Node ID " << start << " or " << end << " is out of bounds." << endl;
+            return {};
+        }
+        const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+        const MapFileEdge* e = edges();
+        const uint32_t* first = outStart();
+        const uint32_t* out = outEdges();
+        vector<double> dist(nodeCount(), std::numeric_limits<double>::infinity());
+        vector<uint32_t> cameFromEdge(nodeCount(), NONE);
+        priority_queue<std::pair<double, uint32_t>,
+            vector<std::pair<double, uint32_t>>,
+            std::greater<std::pair<double, uint32_t>>> pq;
+
+        dist[start] = 0;
+        pq.push({ 0, start });
+        while (!pq.empty()) {
+            double d = pq.top().first;
+            uint32_t u = pq.top().second;
+            pq.pop();
+            if (d > dist[u]) continue;
+            if (u == end) break;
+            for (uint32_t i = first[u]; i < first[u + 1]; ++i) {
+                uint32_t id = out[i];
+                uint32_t v = e[id].to;
+                if (dist[v] > d + e[id].length) {
+                    dist[v] = d + e[id].length;
+                    cameFromEdge[v] = id;
+                    pq.push({ dist[v], v });
+                }
+            }
+        }
+
+        vector<uint32_t> path;
+        for (uint32_t curr = end; curr != start; curr = e[cameFromEdge[curr]].from) {
+            if (cameFromEdge[curr] == NONE) return {};
+            path.push_back(cameFromEdge[curr]);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+private:
+    const char* base = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+    template <typename T>
+    const T* section(uint64_t offset) const { return reinterpret_cast<const T*>(base + offset); }
+
+    // 헤더와 구역 범위 확인 후 레코드 확인
+    bool validate() const {
+        if (size < sizeof(MapFileHeader)) return false;
+        const MapFileHeader& h = header();
+        if (std::memcmp(h.magic, MAP_FILE_MAGIC, sizeof(h.magic)) != 0) return false;
+        if (h.version != MAP_FILE_VERSION || h.fileSize != size) return false;
+        auto fits = [&](uint64_t offset, uint64_t bytes) {
+            return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+        };
+        return fits(h.nodesOffset, (uint64_t)h.nodeCount * sizeof(MapFileNode))
+            && fits(h.edgesOffset, (uint64_t)h.edgeCount * sizeof(MapFileEdge))
+            && fits(h.tagsOffset, (uint64_t)h.tagCount * sizeof(MapFileTag))
+            && fits(h.outStartOffset, ((uint64_t)h.nodeCount + 1) * sizeof(uint32_t))
+            && fits(h.outEdgesOffset, (uint64_t)h.edgeCount * sizeof(uint32_t))
+            && fits(h.stringPoolOffset, h.stringPoolSize)
+            && outStart()[h.nodeCount] == h.edgeCount
+            && validateRecords();
+    }
+
+    // 레코드 확인 (O(노드 + 엣지 + 태그), 매핑된 값을 인덱스로 쓰기 전에 한 번)
+    bool validateRecords() const {
+        const MapFileHeader& h = header();
+        auto inPool = [&](uint32_t offset, uint32_t length) {
+            return offset <= h.stringPoolSize && length <= h.stringPoolSize - offset;
+        };
+        const MapFileNode* n = nodes();
+        for (uint32_t i = 0; i < h.nodeCount; ++i) {
+            if (n[i].type > STREET || !inPool(n[i].nameOffset, n[i].nameLength)) return false;
+        }
+        const MapFileEdge* e = edges();
+        for (uint32_t i = 0; i < h.edgeCount; ++i) {
+            if (e[i].from >= h.nodeCount || e[i].to >= h.nodeCount) return false;
+            if (!(e[i].length >= 0) || !std::isfinite(e[i].length)) return false; // NaN 도 거부
+        }
+        const uint32_t* first = outStart();
+        const uint32_t* out = outEdges();
+        for (uint32_t u = 0; u < h.nodeCount; ++u) {
+            if (first[u] > first[u + 1]) return false; // 단조 증가 + 마지막이 edgeCount 이므로 모두 edgeCount 이하
+            for (uint32_t i = first[u]; i < first[u + 1]; ++i) {
+                if (out[i] >= h.edgeCount || e[out[i]].from != u) return false;
+            }
+        }
+        const MapFileTag* t = tags();
+        for (uint32_t i = 0; i < h.tagCount; ++i) {
+            if (t[i].nodeId >= h.nodeCount || !inPool(t[i].tagOffset, t[i].tagLength)) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief NFC 태그 -> 노드 완전 해시 표 (맵 로드 시 구성, 조회 시 슬롯 1개만 확인)
+ *
+ * hash-and-displace 방식: 태그를 버킷으로 나눈 뒤 큰 버킷부터, 버킷 안의 태그가 모두
+ * 빈 슬롯에 들어가는 seed 를 찾아 둔다. 조회는 태그 해시 1회 + 버킷 seed 로 슬롯 위치를
+ * 바로 계산해 그 슬롯의 태그와 한 번만 비교한다.
+ * 키는 string_view 로 원본 문자열(Map::nfcTagMap 의 키)을 가리키므로 원본이 살아 있어야 한다.
+ */
+class NfcTagIndex {
+public:
+    // 구성 실패(64비트 해시 충돌 등) 시 false, 표는 비워짐
+    bool build(const map<string, Node*, std::less<>>& tags) {
+        clear();
+        if (tags.empty()) return true;
+
+        size_t slotCount = 1, bucketCount = 1;
+        while (slotCount < tags.size() + tags.size() / 4) slotCount <<= 1; // 적재율 0.8 이하
+        while (bucketCount * 4 < tags.size()) bucketCount <<= 1;           // 버킷당 평균 4개 이하
+        slotMask = slotCount - 1;
+        bucketMask = bucketCount - 1;
+
+        vector<Slot> entries;
+        entries.reserve(tags.size());
+        for (const auto& kv : tags) entries.push_back({ hashTag(kv.first), kv.first, kv.second });
+
+        // 버킷별로 묶고 큰 버킷부터 seed 탐색
+        vector<vector<uint32_t>> buckets(bucketCount);
+        for (uint32_t i = 0; i < entries.size(); ++i) buckets[bucketOf(entries[i].hash)].push_back(i);
+        vector<uint32_t> order(bucketCount);
+        for (uint32_t b = 0; b < bucketCount; ++b) order[b] = b;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        const uint32_t MAX_SEED_TRIES = 1u << 20;
+        slots.assign(slotCount, Slot());
+        seeds.assign(bucketCount, 0);
+        vector<char> used(slotCount, 0);
+        vector<uint64_t> positions;
+        for (uint32_t b : order) {
+            const vector<uint32_t>& bucket = buckets[b];
+            if (bucket.empty()) break;
+            uint32_t seed = 0;
+            for (; seed < MAX_SEED_TRIES; ++seed) {
+                positions.clear();
+                bool ok = true;
+                for (uint32_t i : bucket) {
+                    uint64_t pos = slotOf(entries[i].hash, seed);
+                    if (used[pos] || std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+                        ok = false;
+                        break;
+                    }
+                    positions.push_back(pos);
+                }
+                if (ok) break;
+            }
+            if (seed == MAX_SEED_TRIES) {
+                clear();
+                return false;
+            }
+            seeds[b] = seed;
+            for (size_t k = 0; k < bucket.size(); ++k) {
+                used[positions[k]] = 1;
+                slots[positions[k]] = entries[bucket[k]];
+            }
+        }
+        count = entries.size();
+        return true;
+    }
+
+    Node* find(std::string_view tagId) const {
+        if (slots.empty()) return nullptr;
+        uint64_t h = hashTag(tagId);
+        const Slot& slot = slots[slotOf(h, seeds[bucketOf(h)])];
+        return (slot.hash == h && slot.key == tagId) ? slot.node : nullptr;
+    }
+
+    void clear() {
+        slots.clear();
+        seeds.clear();
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t memoryBytes() const { return slots.capacity() * sizeof(Slot) + seeds.capacity() * sizeof(uint32_t); }
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        std::string_view key;
+        Node* node = nullptr;
+    };
+
+    vector<Slot> slots;
+    vector<uint32_t> seeds; // 버킷별 displacement seed
+    uint64_t slotMask = 0;
+    uint64_t bucketMask = 0;
+    size_t count = 0;
+
+    // FNV-1a 64비트
+    static uint64_t hashTag(std::string_view s) {
+        uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // FNV-1a 는 끝자리만 다른 태그(NFC_0, NFC_1, ...)끼리 상위 비트가 거의 같으므로
+    // 64비트 전체를 섞은 뒤(murmur3 fmix64) 버킷 선택 (raw 해시 상위 비트로 고르면 한 버킷에 몰려 구성 실패)
+    uint64_t bucketOf(uint64_t h) const {
+        h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+        h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+        return (h ^ (h >> 33)) & bucketMask;
+    }
+
+    // seed 로 해시를 다시 섞어 슬롯 위치 계산 (splitmix64 마무리 단계)
+    uint64_t slotOf(uint64_t h, uint32_t seed) const {
+        uint64_t x = h + (uint64_t(seed) + 1) * 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return (x ^ (x >> 31)) & slotMask;
+    }
+};
+
+/**
+ * @brief (출발 노드, 도착 노드) -> 엣지 ID 해시 표 (선형 탐사, 적재율 0.5 이하)
+ *
+ * 연속된 NFC 태그 두 개로 지나온 엣지를 찾을 때 사용. 같은 방향 엣지가 여럿이면 먼저 추가된 엣지.
+ */
+class EdgePairIndex {
+public:
+    void build(const vector<int>& from, const vector<int>& to) {
+        size_t capacity = 16;
+        while (capacity < from.size() * 2) capacity <<= 1;
+        mask = capacity - 1;
+        keys.assign(capacity, EMPTY);
+        edgeIds.assign(capacity, -1);
+        for (size_t id = 0; id < from.size(); ++id) {
+            uint64_t key = keyOf(from[id], to[id]);
+            uint64_t pos = hashKey(key) & mask;
+            while (keys[pos] != EMPTY && keys[pos] != key) pos = (pos + 1) & mask;
+            if (keys[pos] == EMPTY) {
+                keys[pos] = key;
+                edgeIds[pos] = (int)id;
+            }
+        }
+    }
+
+    // from -> to 엣지 ID (없으면 -1)
+    int find(int from, int to) const {
+        if (keys.empty()) return -1;
+        uint64_t key = keyOf(from, to);
+        for (uint64_t pos = hashKey(key) & mask; keys[pos] != EMPTY; pos = (pos + 1) & mask) {
+            if (keys[pos] == key) return edgeIds[pos];
+        }
+        return -1;
+    }
+
+    size_t memoryBytes() const { return keys.capacity() * sizeof(uint64_t) + edgeIds.capacity() * sizeof(int); }
+
+private:
+    static constexpr uint64_t EMPTY = ~uint64_t(0);
+
+    vector<uint64_t> keys;
+    vector<int> edgeIds;
+    uint64_t mask = 0;
+
+    static uint64_t keyOf(int from, int to) { return (uint64_t(uint32_t(from)) << 32) | uint32_t(to); }
+
+    // splitmix64 마무리 단계
+    static uint64_t hashKey(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+};
+
+/**
+ * @brief 강한 연결 요소(SCC) + 요소 간 도달 가능 표 (일방통행 때문에 갈 수 없는 노드 쌍 판별)
+ *
+ * Tarjan 알고리즘(반복문 버전)으로 SCC 를 구하면 요소 번호가 역위상 순서로 매겨지므로,
+ * 번호가 작은 요소부터 "자신 + 후속 요소들의 도달 집합" 을 비트셋으로 합쳐 전이 폐포를 만든다.
+ * reachable(a, b) = 같은 요소인지 또는 비트 1개 확인 (O(1)).
+ * 요소 수가 MAX_CLOSURE_COMPONENTS 를 넘으면 폐포(요소 수^2 비트)를 만들지 않고 요소 그래프를 탐색한다.
+ */
+class ReachabilityIndex {
+public:
+    static const size_t MAX_CLOSURE_COMPONENTS = 16384; // 폐포 최대 32MB
+
+    void build(size_t nodeCount, const vector<int>& outStart, const vector<int>& outEdgeIds, const vector<int>& edgeTo) {
+        const int n = (int)nodeCount;
+        component.assign(n, -1);
+        componentSizes.clear();
+        vector<int> index(n, -1), low(n, 0), stack, callStack, nextEdge(n, 0);
+        vector<char> onStack(n, 0);
+        int counter = 0;
+
+        for (int root = 0; root < n; ++root) {
+            if (index[root] >= 0) continue;
+            callStack.push_back(root);
+            index[root] = low[root] = counter++;
+            nextEdge[root] = outStart[root];
+            stack.push_back(root);
+            onStack[root] = 1;
+            while (!callStack.empty()) {
+                int v = callStack.back();
+                if (nextEdge[v] < outStart[v + 1]) {
+                    int w = edgeTo[outEdgeIds[nextEdge[v]++]];
+                    if (index[w] < 0) {
+                        index[w] = low[w] = counter++;
+                        nextEdge[w] = outStart[w];
+                        stack.push_back(w);
+                        onStack[w] = 1;
+                        callStack.push_back(w);
+                    }
+                    else if (onStack[w]) {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+                callStack.pop_back();
+                if (!callStack.empty()) low[callStack.back()] = std::min(low[callStack.back()], low[v]);
+                if (low[v] == index[v]) { // v 가 요소의 루트
+                    int c = (int)componentSizes.size();
+                    componentSizes.push_back(0);
+                    int w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = 0;
+                        component[w] = c;
+                        componentSizes[c]++;
+                    } while (w != v);
+                }
+            }
+        }
+
+        // 요소 그래프 (CSR, 중복 간선 제거)
+        const size_t C = componentSizes.size();
+        vector<std::pair<int, int>> links;
+        for (int v = 0; v < n; ++v) {
+            for (int i = outStart[v]; i < outStart[v + 1]; ++i) {
+                int a = component[v], b = component[edgeTo[outEdgeIds[i]]];
+                if (a != b) links.push_back({ a, b });
+            }
+        }
+        std::sort(links.begin(), links.end());
+        links.erase(std::unique(links.begin(), links.end()), links.end());
+        componentStart.assign(C + 1, 0);
+        componentLinks.resize(links.size());
+        for (const auto& l : links) componentStart[l.first + 1]++;
+        for (size_t c = 0; c < C; ++c) componentStart[c + 1] += componentStart[c];
+        for (size_t i = 0; i < links.size(); ++i) componentLinks[i] = links[i].second;
+
+        // 전이 폐포: 후속 요소는 번호가 더 작으므로 작은 번호부터 채우면 됨
+        closure.clear();
+        words = (C + 63) / 64;
+        if (C <= MAX_CLOSURE_COMPONENTS) {
+            closure.assign(C * words, 0);
+            for (size_t c = 0; c < C; ++c) {
+                uint64_t* row = &closure[c * words];
+                row[c / 64] |= uint64_t(1) << (c % 64);
+                for (int i = componentStart[c]; i < componentStart[c + 1]; ++i) {
+                    const uint64_t* next = &closure[(size_t)componentLinks[i] * words];
+                    for (size_t k = 0; k < words; ++k) row[k] |= next[k];
+                }
+            }
+        }
+    }
+
+    bool reachable(int a, int b) const {
+        int ca = component[a], cb = component[b];
+        if (ca == cb) return true;
+        if (ca < cb) return false; // 역위상 순서: 후속 요소는 항상 번호가 더 작음
+        if (!closure.empty()) return (closure[(size_t)ca * words + cb / 64] >> (cb % 64)) & 1;
+        return searchComponents(ca, cb);
+    }
+
+    int componentOf(int v) const { return component[v]; }
+    size_t componentCount() const { return componentSizes.size(); }
+    int largestComponentSize() const {
+        return componentSizes.empty() ? 0 : *std::max_element(componentSizes.begin(), componentSizes.end());
+    }
+    size_t memoryBytes() const {
+        return (component.capacity() + componentSizes.capacity() + componentStart.capacity() + componentLinks.capacity()) * sizeof(int)
+            + closure.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    vector<int> component;      // 노드 -> 요소 번호
+    vector<int> componentSizes;
+    vector<int> componentStart, componentLinks; // 요소 그래프 (CSR)
+    vector<uint64_t> closure;   // 요소 c 의 도달 집합 = closure[c * words .. (c + 1) * words)
+    size_t words = 0;
+
+    // 폐포가 없을 때 요소 그래프 탐색. 방문 표시는 스레드별로 두어 여러 세션이 같은 표를 동시에 조회할 수 있다
+    bool searchComponents(int from, int to) const {
+        thread_local vector<uint32_t> visitStamp;
+        thread_local uint32_t currentVisit = 0;
+        if (visitStamp.size() < componentSizes.size()) visitStamp.resize(componentSizes.size(), 0);
+        if (++currentVisit == 0) {
+            std::fill(visitStamp.begin(), visitStamp.end(), 0);
+            currentVisit = 1;
+        }
+        vector<int> pending = { from };
+        visitStamp[from] = currentVisit;
+        while (!pending.empty()) {
+            int c = pending.back();
+            pending.pop_back();
+            for (int i = componentStart[c]; i < componentStart[c + 1]; ++i) {
+                int next = componentLinks[i];
+                if (next == to) return true;
+                if (next > to && visitStamp[next] != currentVisit) { // 번호가 to 보다 작으면 to 에 못 감
+                    visitStamp[next] = currentVisit;
+                    pending.push_back(next);
+                }
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief 경로 합산 지표 (총 거리, 신호 수, 평균 신호 대기를 포함한 예상 소요 시간)
+ */
+struct RouteMetrics {
+    double distanceKm = 0;
+    int lights = 0;
+    double etaSec = 0;
+};
+
+/**
+ * @brief 엣지 속성 SoA(Structure of Arrays) 저장소 (엣지 ID 로 인덱싱)
+ *
+ * 경로 지표 합산처럼 속성 한두 개만 훑는 연산이 필요한 배열만 읽도록 속성별로 나눠 둔다.
+ * "도착 노드가 교차로" 여부는 64개씩 묶은 비트마스크로 보관한다.
+ */
+struct EdgeStore {
+    vector<double> length;     // km
+    vector<double> speedLimit; // km/h
+    vector<int> from;          // 출발 노드 ID
+    vector<int> to;            // 도착 노드 ID
+    vector<uint8_t> oneWay;
+    vector<uint64_t> toIntersectionMask; // bit (id % 64) of word (id / 64)
+
+    size_t size() const { return length.size(); }
+
+    void append(const Edge* e) {
+        size_t id = length.size();
+        length.push_back(e->length);
+        speedLimit.push_back(e->speedLimit);
+        from.push_back(e->from->id);
+        to.push_back(e->to->id);
+        oneWay.push_back(e->isOneWay ? 1 : 0);
+        if (id % 64 == 0) toIntersectionMask.push_back(0);
+        if (e->to->type == INTERSECTION) toIntersectionMask[id / 64] |= uint64_t(1) << (id % 64);
+    }
+
+    int targetIsIntersection(int id) const {
+        return (int)((toIntersectionMask[id >> 6] >> (id & 63)) & 1);
+    }
+
+    size_t memoryBytes() const {
+        return (length.capacity() + speedLimit.capacity()) * sizeof(double) + (from.capacity() + to.capacity()) * sizeof(int)
+            + oneWay.capacity() + toIntersectionMask.capacity() * sizeof(uint64_t);
+    }
+
+    /**
+     * @brief 경로(엣지 ID 목록)의 지표 합산
+     * @param etaWeights 엣지별 소요 시간 가중치 (예: Map::edgeWeights[METRIC_LIGHT_AWARE])
+     *
+     * 누산기를 4개로 나눠 의존성 사슬을 끊어 두었으므로, 컴파일러가 gather 기반
+     * SIMD 로 벡터화하거나 최소한 4개의 덧셈을 병렬로 실행할 수 있다.
+     */
+    RouteMetrics summarize(const int* ids, size_t count, const double* etaWeights) const {
+        const double* len = length.data();
+        double dist[4] = { 0, 0, 0, 0 };
+        double eta[4] = { 0, 0, 0, 0 };
+        int lights[4] = { 0, 0, 0, 0 };
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (int lane = 0; lane < 4; ++lane) {
+                int id = ids[i + lane];
+                dist[lane] += len[id];
+                eta[lane] += etaWeights[id];
+                lights[lane] += targetIsIntersection(id);
+            }
+        }
+        for (; i < count; ++i) {
+            dist[0] += len[ids[i]];
+            eta[0] += etaWeights[ids[i]];
+            lights[0] += targetIsIntersection(ids[i]);
+        }
+        RouteMetrics m;
+        m.distanceKm = (dist[0] + dist[1]) + (dist[2] + dist[3]);
+        m.etaSec = (eta[0] + eta[1]) + (eta[2] + eta[3]);
+        m.lights = (lights[0] + lights[1]) + (lights[2] + lights[3]);
+        return m;
+    }
+};
+
+// 정수화한 가중치 단위 (거리: m, 시간: 0.1초)
+const double INT_WEIGHT_SCALE[METRIC_COUNT] = { 1000.0, 10.0, 10.0 };
+const uint32_t INT_WEIGHT_BLOCKED = std::numeric_limits<uint32_t>::max(); // 통행 불가 (제한속도 0, 도로 통제)
+
+// 가중치를 INT_WEIGHT_SCALE 단위 정수로 반올림 (무한대/범위 초과는 INT_WEIGHT_BLOCKED)
+inline uint32_t toIntWeight(double w, int metric) {
+    double scaled = std::round(w * INT_WEIGHT_SCALE[metric]);
+    return scaled < INT_WEIGHT_BLOCKED ? (uint32_t)scaled : INT_WEIGHT_BLOCKED;
+}
+
+// x != 0 인 64비트 정수의 최상위 비트 위치
+inline int highestBit(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+/**
+ * @brief 단조 정수 우선순위 큐 (radix heap)
+ *
+ * 다익스트라처럼 꺼내는 키가 줄어들지 않을 때만 사용 가능. 원소는 "마지막으로 꺼낸 키와 처음 달라지는 비트"
+ * 위치의 버킷에 들어가고, 0번 버킷이 비면 가장 낮은 비어 있지 않은 버킷을 새 최솟값 기준으로 다시 나눈다.
+ * 원소마다 버킷 이동은 최대 64번이라 비교 기반 힙보다 상수가 작고, 버킷 vector 는 clear 후에도 용량을 재사용한다.
+ * 버킷 배열은 처음 push 할 때 만든다 (radix 탐색을 쓰지 않는 작업 공간은 vector 하나 크기만 차지).
+ */
+class RadixHeap {
+public:
+    static const int BUCKETS = 65;
+
+    void clear() {
+        for (auto& bucket : buckets) bucket.clear();
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    // key >= 마지막으로 꺼낸 키
+    void push(uint64_t key, int value) {
+        if (buckets.empty()) buckets.resize(BUCKETS);
+        buckets[bucketOf(key)].push_back({ key, value });
+        ++count;
+    }
+
+    std::pair<uint64_t, int> pop() {
+        if (buckets[0].empty()) {
+            size_t i = 1;
+            while (buckets[i].empty()) ++i;
+            uint64_t newLast = buckets[i][0].first;
+            for (const auto& item : buckets[i]) newLast = std::min(newLast, item.first);
+            last = newLast;
+            for (const auto& item : buckets[i]) buckets[bucketOf(item.first)].push_back(item);
+            buckets[i].clear();
+        }
+        std::pair<uint64_t, int> top = buckets[0].back();
+        buckets[0].pop_back();
+        --count;
+        return top;
+    }
+
+private:
+    vector<vector<std::pair<uint64_t, int>>> buckets;
+    uint64_t last = 0;
+    size_t count = 0;
+
+    size_t bucketOf(uint64_t key) const { return key == last ? 0 : highestBit(key ^ last) + 1; }
+};
+
+// findPath 탐색 방식
+enum SearchMode {
+    SEARCH_FORWARD,       // start 에서 end 를 꺼낼 때까지 한 방향으로 탐색
+    SEARCH_BIDIRECTIONAL, // start(정방향)와 end(역방향)에서 동시에 탐색해 중간에서 만남
+    SEARCH_RADIX          // 정수화한 가중치(m, 0.1초)로 radix heap 정방향 탐색 (반올림 오차 안에서 최단)
+};
+
+/**
+ * @brief 다익스트라 탐색 작업 공간 (노드별 거리 / 이전 엣지)
+ *
+ * 방문 표시(stamp)를 세대 번호로 관리하므로, 노드 수와 관계없이 탐색 시작 시 O(1) 로 초기화된다.
+ */
+struct SearchWorkspace {
+    vector<double> dist;
+    vector<double> km; // 경로 거리 (도착 시각 탐색에서만 채움)
+    vector<int> parentEdge;
+    vector<uint32_t> stamp;
+    uint32_t currentStamp = 0;
+    priority_queue<std::pair<double, int>,
+        vector<std::pair<double, int>>,
+        std::greater<std::pair<double, int>>> pq;
+    RadixHeap radix; // SEARCH_RADIX 용
+
+    void reset(size_t nodeCount) {
+        if (stamp.size() < nodeCount) {
+            dist.resize(nodeCount);
+            km.resize(nodeCount);
+            parentEdge.resize(nodeCount);
+            stamp.resize(nodeCount, 0);
+        }
+        if (++currentStamp == 0) { // 세대 번호가 한 바퀴 돌면 실제로 초기화
+            std::fill(stamp.begin(), stamp.end(), 0);
+            currentStamp = 1;
+        }
+        pq = {};
+        radix.clear();
+    }
+
+    double distanceOf(int v) const {
+        return stamp[v] == currentStamp ? dist[v] : std::numeric_limits<double>::infinity();
+    }
+
+    void set(int v, double d, int viaEdge) {
+        stamp[v] = currentStamp;
+        dist[v] = d;
+        parentEdge[v] = viaEdge;
+    }
+
+    // 노드별 배열 크기 (큐는 탐색이 끝나면 비므로 제외)
+    size_t memoryBytes() const {
+        return sizeof(*this) + (dist.capacity() + km.capacity()) * sizeof(double)
+            + parentEdge.capacity() * sizeof(int) + stamp.capacity() * sizeof(uint32_t);
+    }
+};
+
+/**
+ * @brief 도로 통제/혼잡 오버레이 (엣지별 통행 금지 + 소요 시간 배율, 실행 중 적용)
+ *
+ * 맵의 기본 가중치는 그대로 두고, 처음 변경될 때 비용 함수별 가중치 배열을 한 번 복사한 뒤
+ * 이후로는 바뀐 엣지 항목만 고친다 (이벤트 1건 = 엣지 수와 무관한 O(1), 맵/인덱스 재구성 없음).
+ * 기본값과 달라진 엣지 목록(changedEdges)을 유지하므로, 기본 가중치로 미리 만든 구조(목적지 트리 등)는
+ * 이 목록만 확인해 영향받는 것만 버릴 수 있다.
+ */
+class RoadOverlay {
+public:
+    // base: 기본 가중치 (Map::edgeWeights / edgeWeightsInt, 맵이 살아 있는 동안 유효)
+    void bind(const vector<double>* baseWeights, const vector<uint32_t>* baseWeightsInt) {
+        base = baseWeights;
+        baseInt = baseWeightsInt;
+        clear();
+    }
+
+    // 엣지 통행 금지/해제
+    void setClosed(int edgeId, bool isClosed) {
+        ensureCopied();
+        if ((closed[edgeId] != 0) != isClosed) closedCount += isClosed ? 1 : -1;
+        closed[edgeId] = isClosed ? 1 : 0;
+        apply(edgeId);
+    }
+
+    // 소요 시간 배율 (timeFactor > 0, 혼잡 > 1, 1 = 정상). 거리 비용과 신호 대기 시간은 바뀌지 않음
+    void setFactor(int edgeId, double timeFactor) {
+        ensureCopied();
+        factor[edgeId] = (float)timeFactor;
+        apply(edgeId);
+    }
+
+    // 모든 변경 취소 (복사한 배열은 다음 변경 때 다시 씀)
+    void clear() {
+        while (!changed.empty()) {
+            int e = changed.back();
+            closed[e] = 0;
+            factor[e] = 1.0f;
+            apply(e);
+        }
+        closedCount = 0;
+        ++revision;
+    }
+
+    bool empty() const { return changed.empty(); }
+    bool anyClosed() const { return closedCount > 0; } // 혼잡만 있으면 false (도로 거리는 그대로)
+    uint64_t version() const { return revision; }
+    bool isClosed(int edgeId) const { return copied && closed[edgeId]; }
+    double factorOf(int edgeId) const { return copied ? factor[edgeId] : 1.0; }
+    const vector<int>& changedEdges() const { return changed; } // 기본 가중치와 다른 엣지
+
+    // 탐색용 가중치 (변경이 없으면 기본 배열 그대로)
+    const vector<double>& weights(int metric) const { return changed.empty() ? base[metric] : weightsCopy[metric]; }
+    const vector<uint32_t>& weightsInt(int metric) const { return changed.empty() ? baseInt[metric] : weightsIntCopy[metric]; }
+
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(*this) + factor.capacity() * sizeof(float) + closed.capacity()
+            + (changed.capacity() + changedPos.capacity()) * sizeof(int);
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            bytes += weightsCopy[m].capacity() * sizeof(double) + weightsIntCopy[m].capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    const vector<double>* base = nullptr;
+    const vector<uint32_t>* baseInt = nullptr;
+    vector<double> weightsCopy[METRIC_COUNT];
+    vector<uint32_t> weightsIntCopy[METRIC_COUNT];
+    bool copied = false;
+    vector<float> factor;    // 엣지별 소요 시간 배율
+    vector<uint8_t> closed;  // 엣지별 통행 금지
+    vector<int> changed;
+    vector<int> changedPos;  // 엣지 -> changed 위치 (-1: 기본값)
+    size_t closedCount = 0;  // 통행 금지 엣지 수
+    uint64_t revision = 0;
+
+    void ensureCopied() {
+        if (copied) return;
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            weightsCopy[m] = base[m];
+            weightsIntCopy[m] = baseInt[m];
+        }
+        size_t edgeCount = base[METRIC_DISTANCE].size();
+        factor.assign(edgeCount, 1.0f);
+        closed.assign(edgeCount, 0);
+        changedPos.assign(edgeCount, -1);
+        copied = true;
+    }
+
+    // 엣지 e 의 가중치를 현재 통제/배율로 다시 계산하고 변경 목록 갱신
+    void apply(int e) {
+        const double INF = std::numeric_limits<double>::infinity();
+        double freeFlow = base[METRIC_FREE_FLOW][e];
+        if (closed[e]) {
+            for (int m = 0; m < METRIC_COUNT; ++m) weightsCopy[m][e] = INF;
+        }
+        else {
+            double lightWait = freeFlow < INF ? base[METRIC_LIGHT_AWARE][e] - freeFlow : 0.0;
+            weightsCopy[METRIC_DISTANCE][e] = base[METRIC_DISTANCE][e];
+            weightsCopy[METRIC_FREE_FLOW][e] = freeFlow * factor[e];
+            weightsCopy[METRIC_LIGHT_AWARE][e] = freeFlow * factor[e] + lightWait;
+        }
+        for (int m = 0; m < METRIC_COUNT; ++m) weightsIntCopy[m][e] = toIntWeight(weightsCopy[m][e], m);
+
+        bool isDefault = !closed[e] && factor[e] == 1.0f;
+        if (isDefault && changedPos[e] >= 0) { // 목록에서 제거 (마지막 항목과 자리 바꿈)
+            int last = changed.back();
+            changed[changedPos[e]] = last;
+            changedPos[last] = changedPos[e];
+            changed.pop_back();
+            changedPos[e] = -1;
+        }
+        else if (!isDefault && changedPos[e] < 0) {
+            changedPos[e] = (int)changed.size();
+            changed.push_back(e);
+        }
+        ++revision;
+    }
+};
+
+/**
+ * @brief 탐색 호출자(게임 세션, 스레드)별 상태 묶음: 작업 공간 + 도로 통제 오버레이
+ * Map 의 탐색 함수는 맵을 읽기만 하고 이 묶음에만 쓰므로, 호출자마다 따로 두면
+ * 같은 Map 을 동시에 탐색할 수 있다.
+ */
+struct SearchScratch {
+    const RoadOverlay* overlay = nullptr; // 있으면 통제/혼잡이 반영된 가중치로 탐색
+    SearchWorkspace forward, backward;
+    vector<uint32_t> blockedNodeStamp, blockedEdgeStamp; // 대안 경로 탐색용 차단 표시 (세대 번호가 같으면 차단됨)
+    uint32_t blockStamp = 0;
+
+    size_t memoryBytes() const {
+        return forward.memoryBytes() + backward.memoryBytes()
+            + (blockedNodeStamp.capacity() + blockedEdgeStamp.capacity()) * sizeof(uint32_t);
+    }
+};
+
+// -----------------------------------------------------------------
+// 기본 맵 (16개 노드) - 컴파일 시간 상수 표. Map::buildMap 은 이 표를 그대로 읽어 구성한다.
+// -----------------------------------------------------------------
+
+struct DefaultMapNode {
+    std::string_view name;
+    NodeType type;
+};
+
+struct DefaultMapEdge {
+    int from;
+    int to;
+    double length;     // km
+    double speedLimit; // km/h
+    bool oneWay;
+};
+
+struct DefaultMapTag {
+    std::string_view tag;
+    int nodeId;
+};
+
+struct DefaultMapSignal {
+    int nodeId;
+    double cycleSec;
+    double offsetSec;
+    double greenRatio;
+};
+
+// 노드 ID = 표의 순서
+constexpr DefaultMapNode DEFAULT_MAP_NODES[] = {
+    { "S1: 뜨끈국밥", STORE }, { "S2: 바삭치킨", STORE }, { "S3: 달콤케이크", STORE }, { "S4: 시원음료", STORE },
+    { "H1: 101동", HOUSE }, { "H2: 102동", HOUSE }, { "H3: 201동", HOUSE },
+    { "H4: 202동", HOUSE }, { "H5: 301동", HOUSE }, { "H6: 302동", HOUSE },
+    { "I1: 사거리A", INTERSECTION }, { "I2: 사거리B", INTERSECTION },
+    { "I3: 삼거리C", INTERSECTION }, { "I4: 삼거리D", INTERSECTION },
+    { "ST1: 중앙로", STREET }, { "ST2: 골목길", STREET },
+};
+
+// 신호 주기: 1분 주기, 교차로마다 15초씩 어긋나게 연동
+constexpr DefaultMapSignal DEFAULT_MAP_SIGNALS[] = {
+    { 10, 60.0, 0.0, 0.5 },  // I1
+    { 11, 60.0, 15.0, 0.5 }, // I2
+    { 12, 60.0, 30.0, 0.6 }, // I3 (삼거리)
+    { 13, 60.0, 45.0, 0.6 }, // I4 (삼거리)
+};
+
+// 태그 문자열 순으로 정렬 (defaultMapNodeByTag 이진 탐색, nfcTagMap 끝에 차례로 삽입)
+constexpr DefaultMapTag DEFAULT_MAP_TAGS[] = {
+    { "NFC_H1", 4 }, { "NFC_H2", 5 }, { "NFC_H3", 6 }, { "NFC_H4", 7 }, { "NFC_H5", 8 }, { "NFC_H6", 9 },
+    { "NFC_I1", 10 }, { "NFC_I2", 11 }, { "NFC_I3", 12 }, { "NFC_I4", 13 },
+    { "NFC_S1", 0 }, { "NFC_S2", 1 }, { "NFC_S3", 2 }, { "NFC_S4", 3 },
+    { "NFC_ST1", 14 }, { "NFC_ST2", 15 },
+};
+
+constexpr DefaultMapEdge DEFAULT_MAP_EDGES[] = {
+    { 0, 14, 0.2, 40, false },  // S1 <-> ST1
+    { 14, 10, 0.3, 50, false }, // ST1 <-> I1
+    { 1, 10, 0.4, 50, false },  // S2 <-> I1
+    { 10, 11, 1.0, 60, false }, // I1 <-> I2
+    { 10, 12, 1.2, 60, false }, // I1 <-> I3
+    { 2, 15, 0.3, 40, false },  // S3 <-> ST2
+    { 15, 11, 0.3, 50, false }, // ST2 <-> I2
+    { 3, 12, 0.7, 50, false },  // S4 <-> I3
+    { 11, 13, 1.1, 70, false }, // I2 <-> I4 (고속)
+    { 12, 13, 1.3, 70, false }, // I3 <-> I4 (고속)
+    { 11, 4, 0.3, 30, false },  // I2 <-> H1 (스쿨존)
+    { 11, 5, 0.4, 30, false },  // I2 <-> H2
+    { 12, 6, 0.5, 40, false },  // I3 <-> H3
+    { 12, 7, 0.4, 40, false },  // I3 <-> H4
+    { 13, 8, 0.8, 50, false },  // I4 <-> H5
+    { 13, 9, 0.9, 50, false },  // I4 <-> H6
+    { 4, 5, 0.2, 30, true },    // H1 -> H2 (일방통행)
+};
+
+constexpr int DEFAULT_MAP_NODE_COUNT = (int)(sizeof(DEFAULT_MAP_NODES) / sizeof(DEFAULT_MAP_NODES[0]));
+
+constexpr int defaultMapDirectedEdgeCount() {
+    int count = 0;
+    for (const DefaultMapEdge& e : DEFAULT_MAP_EDGES) count += e.oneWay ? 1 : 2;
+    return count;
+}
+
+// 노드 쌍별 최단 거리 (km, 갈 수 없으면 무한대) - 컴파일 시간 Floyd-Warshall
+constexpr std::array<std::array<double, DEFAULT_MAP_NODE_COUNT>, DEFAULT_MAP_NODE_COUNT> computeDefaultMapDistances() {
+    std::array<std::array<double, DEFAULT_MAP_NODE_COUNT>, DEFAULT_MAP_NODE_COUNT> d{};
+    for (int i = 0; i < DEFAULT_MAP_NODE_COUNT; ++i) {
+        for (int j = 0; j < DEFAULT_MAP_NODE_COUNT; ++j) d[i][j] = i == j ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+    for (const DefaultMapEdge& e : DEFAULT_MAP_EDGES) {
+        if (e.length < d[e.from][e.to]) d[e.from][e.to] = e.length;
+        if (!e.oneWay && e.length < d[e.to][e.from]) d[e.to][e.from] = e.length;
+    }
+    for (int k = 0; k < DEFAULT_MAP_NODE_COUNT; ++k) {
+        for (int i = 0; i < DEFAULT_MAP_NODE_COUNT; ++i) {
+            for (int j = 0; j < DEFAULT_MAP_NODE_COUNT; ++j) {
+                if (d[i][k] + d[k][j] < d[i][j]) d[i][j] = d[i][k] + d[k][j];
+            }
+        }
+    }
+    return d;
+}
+
+constexpr auto DEFAULT_MAP_DISTANCE_KM = computeDefaultMapDistances();
+
+// 태그 -> 노드 ID (없으면 -1)
+constexpr int defaultMapNodeByTag(std::string_view tag) {
+    int lo = 0, hi = (int)(sizeof(DEFAULT_MAP_TAGS) / sizeof(DEFAULT_MAP_TAGS[0]));
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (DEFAULT_MAP_TAGS[mid].tag < tag) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < (int)(sizeof(DEFAULT_MAP_TAGS) / sizeof(DEFAULT_MAP_TAGS[0])) && DEFAULT_MAP_TAGS[lo].tag == tag
+        ? DEFAULT_MAP_TAGS[lo].nodeId : -1;
+}
+
+constexpr bool defaultMapTagsSorted() {
+    for (size_t i = 1; i < sizeof(DEFAULT_MAP_TAGS) / sizeof(DEFAULT_MAP_TAGS[0]); ++i) {
+        if (!(DEFAULT_MAP_TAGS[i - 1].tag < DEFAULT_MAP_TAGS[i].tag)) return false;
+    }
+    return true;
+}
+
+constexpr bool defaultMapStoresReachHouses() {
+    for (int s = 0; s < DEFAULT_MAP_NODE_COUNT; ++s) {
+        for (int h = 0; h < DEFAULT_MAP_NODE_COUNT; ++h) {
+            if (DEFAULT_MAP_NODES[s].type == STORE && DEFAULT_MAP_NODES[h].type == HOUSE
+                && DEFAULT_MAP_DISTANCE_KM[s][h] == std::numeric_limits<double>::infinity()) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(defaultMapTagsSorted(), "DEFAULT_MAP_TAGS must be sorted by tag");
+static_assert(defaultMapStoresReachHouses(), "every store must reach every house in the default map");
+static_assert(defaultMapNodeByTag("NFC_ST2") == 15 && defaultMapNodeByTag("NFC_X") == -1, "default map tag table");
+
+/**
+ * @brief 경로 탐색 결과 (경로 엣지 ID + 거리, 신호 수, 신호 대기를 포함한 소요 시간)
+ */
+struct Route {
+    vector<int> edgeIds;
+    double distanceKm = 0;
+    int lights = 0;
+    double etaSec = 0; // 출발부터 도착까지 소요 시간 (초)
+    bool found = false;
+};
+
+class Map {
+public:
+    vector<Node*> nodes;
+    vector<Edge*> edges;
+    map<Node*, vector<Edge*>> adj;
+    vector<Node*> stores;
+    vector<Node*> houses;
+    map<string, Node*, std::less<>> nfcTagMap;
+    NfcTagIndex nfcIndex;      // nfcTagMap 으로 만든 조회용 완전 해시 표
+    bool nfcIndexDirty = true; // 태그 추가 후 재구성 필요
+
+    // 비용 함수별 엣지 가중치. edges[i] 의 가중치 = edgeWeights[metric][i]
+    // (엣지 추가 시 미리 계산해 두므로 탐색 중에는 분기 없이 배열만 읽음)
+    vector<double> edgeWeights[METRIC_COUNT];
+    vector<uint32_t> edgeWeightsInt[METRIC_COUNT]; // INT_WEIGHT_SCALE 단위로 반올림한 가중치 (SEARCH_RADIX 용)
+    EdgeStore edgeStore; // 경로 지표 합산용 엣지 속성 배열 (edges 와 같은 순서)
+
+    // 탐색용 인접 인덱스 (CSR, 엣지 추가 후 첫 탐색 때 다시 구성)
+    // outEdgeIds[outStart[v] .. outStart[v+1]) = v 에서 나가는 엣지, inEdgeIds = v 로 들어오는 엣지
+    vector<int> outStart, outEdgeIds;
+    vector<int> inStart, inEdgeIds;
+    EdgePairIndex edgePairs; // (from, to) -> 엣지 ID
+    bool routingIndexDirty = true;
+    ReachabilityIndex reachability; // 강한 연결 요소 + 도달 가능 표 (인접 인덱스를 다시 만들면 다시 구성)
+    bool reachabilityDirty = true;
+    uint64_t mapVersion = 0; // 노드 추가, 엣지 가중치 변경마다 증가 (경로 캐시 무효화 기준)
+    uint64_t defaultMapVersion = UINT64_MAX; // buildMap 직후의 mapVersion (그대로면 기본 맵 거리 표 사용)
+    SearchScratch scratch;   // 맵을 혼자 쓸 때(도구/벤치마크)의 작업 공간. 게임 세션은 MapSession 의 것을 씀
+
+    // 교차로 신호 주기 (nodes[i] 의 신호 = signalPlans[i], 교차로가 아니면 사용하지 않음)
+    // 주기는 맵에 고정이고, 현재 신호/변경 예약/변경 기록은 세션마다 다르므로 MapSession 이 가진다.
+    vector<SignalPlan> signalPlans;
+
+    // 노드, 엣지, 노드 이름은 모두 아레나에 연속으로 배치 (Map 소멸 시 블록 단위로 일괄 해제)
+    MonotonicArena arena;
+
+    // 기본 맵 구성 (DEFAULT_MAP_* 상수 표, 노드 이름은 상수 문자열을 복사 없이 가리킴)
+    void buildMap() {
+        const int directedEdges = defaultMapDirectedEdgeCount();
+        nodes.reserve(DEFAULT_MAP_NODE_COUNT);
+        edges.reserve(directedEdges);
+        arena.reserve(DEFAULT_MAP_NODE_COUNT * sizeof(Node) + directedEdges * sizeof(Edge) + 64);
+
+        // 1. 노드, 신호, NFC 태그
+        for (const DefaultMapNode& n : DEFAULT_MAP_NODES) addNode(n.name, n.type, true);
+        for (const DefaultMapSignal& sig : DEFAULT_MAP_SIGNALS) {
+            setSignalPlan(sig.nodeId, sig.cycleSec, sig.offsetSec, sig.greenRatio);
+        }
+        for (const DefaultMapTag& t : DEFAULT_MAP_TAGS) {
+            nfcTagMap.emplace_hint(nfcTagMap.end(), string(t.tag), nodes[t.nodeId]); // 정렬된 표라 끝에 삽입
+        }
+        buildNfcIndex();
+
+        // 2. 엣지(도로)
+        for (const DefaultMapEdge& e : DEFAULT_MAP_EDGES) addEdge(e.from, e.to, e.length, e.speedLimit, e.oneWay);
+
+        prepareIndexes();
+        if (nodes.size() == (size_t)DEFAULT_MAP_NODE_COUNT) defaultMapVersion = mapVersion; // 빈 맵에서 만든 경우만
+    }
+
+    // 노드 추가 (ID 는 추가 순서), 가게/집 목록도 함께 갱신
+    // staticName: 이름이 프로그램 끝까지 유효한 상수 문자열이면 아레나로 복사하지 않음
+    Node* addNode(std::string_view name, NodeType type, bool staticName = false) {
+        Node* n = arena.create<Node>((int)nodes.size(), staticName ? name : arena.copyString(name), type);
+        nodes.push_back(n);
+        if (type == STORE) stores.push_back(n);
+        else if (type == HOUSE) houses.push_back(n);
+        if (signalPlans.size() < nodes.size()) signalPlans.resize(nodes.size());
+        ++mapVersion;
+        return n;
+    }
+
+    void addNfcTag(const string& tagId, int nodeId) {
+        if (nodeId < 0 || (size_t)nodeId >= nodes.size()) {
+            std::cerr << "[Map Error] NFC tag " << tagId << " refers to unknown node " << nodeId << endl;
+            return;
+        }
+        nfcTagMap[tagId] = nodes[nodeId];
+        nfcIndexDirty = true;
+    }
+
+    // NFC 태그 조회 표 구성 (맵 로드 시 호출)
+    void buildNfcIndex() {
+        if (!nfcIndex.build(nfcTagMap)) {
+            std::cerr << "[NFC Error] Tag index build failed, falling back to tag map lookup." << endl;
+        }
+        nfcIndexDirty = false;
+    }
+
+    void addEdge(int fromId, int toId, double len, double sl, bool oneWay = false) {
+        if ((size_t)fromId >= nodes.size() || (size_t)toId >= nodes.size()) { // 음수 ID 도 범위 밖으로 처리
+            std::cerr << "[Map Error] Node ID " << fromId << " or " << toId << " is out of bounds." << endl;
+            return;
+        }
+        Node* from = nodes[fromId];
+        Node* to = nodes[toId];
+        addDirectedEdge(from, to, len, sl, oneWay);
+        if (!oneWay) {
+            addDirectedEdge(to, from, len, sl, oneWay);
+        }
+    }
+
+    Edge* addDirectedEdge(Node* from, Node* to, double len, double sl, bool oneWay) {
+        Edge* e = arena.create<Edge>((int)edges.size(), from, to, len, sl, oneWay);
+        edges.push_back(e);
+        adj[from].push_back(e);
+        edgeStore.append(e);
+        routingIndexDirty = true;
+        computeEdgeWeights(e);
+        return e;
+    }
+
+    /**
+     * @brief 바이너리 맵 파일에서 게임용 맵 구성 (빈 Map 에서만 호출)
+     */
+    bool loadFromFile(const MapFile& file) {
+        if (!nodes.empty()) {
+            std::cerr << "[Map Error] loadFromFile requires an empty map." << endl;
+            return false;
+        }
+        const MapFileNode* fileNodes = file.nodes();
+        nodes.reserve(file.nodeCount());
+        edges.reserve(file.edgeCount());
+        arena.reserve(file.nodeCount() * sizeof(Node) + file.edgeCount() * sizeof(Edge)
+            + file.header().stringPoolSize + 64);
+        for (uint32_t i = 0; i < file.nodeCount(); ++i) {
+            addNode(file.nodeName(i), (NodeType)fileNodes[i].type);
+            if (fileNodes[i].type == INTERSECTION) {
+                setSignalPlan((int)i, fileNodes[i].signalCycleSec, fileNodes[i].signalOffsetSec,
+                    fileNodes[i].signalGreenRatio);
+            }
+        }
+        const MapFileEdge* fileEdges = file.edges();
+        for (uint32_t i = 0; i < file.edgeCount(); ++i) {
+            const MapFileEdge& fe = fileEdges[i];
+            addDirectedEdge(nodes[fe.from], nodes[fe.to], fe.length, fe.speedLimit, fe.isOneWay != 0);
+        }
+        for (uint32_t i = 0; i < file.tagCount(); ++i) {
+            addNfcTag(string(file.tagName(i)), (int)file.tags()[i].nodeId);
+        }
+        prepareIndexes();
+        return true;
+    }
+
+    // 신호 주기 설정/변경: 그 교차로로 들어오는 엣지의 신호 대기 가중치도 바로 다시 계산하고 mapVersion 을 올린다
+    // (목적지 트리, 길안내 경로, 경로 캐시가 낡은 가중치를 쓰지 않도록. 호출자가 rebuildEdgeWeights 를 부를 필요 없음)
+    void setSignalPlan(int nodeId, double cycleSec, double offsetSec, double greenRatio) {
+        if ((size_t)nodeId >= signalPlans.size()) signalPlans.resize((size_t)nodeId + 1);
+        SignalPlan& plan = signalPlans[nodeId];
+        plan.cycleSec = cycleSec;
+        plan.offsetSec = offsetSec;
+        plan.greenRatio = greenRatio;
+        if (!routingIndexDirty) {
+            for (int i = inStart[nodeId]; i < inStart[nodeId + 1]; ++i) computeEdgeWeights(edges[inEdgeIds[i]]);
+        }
+        else { // 맵 구성 중 (인접 인덱스 전): 도착 노드 배열에서 찾음
+            for (size_t id = 0; id < edgeStore.size(); ++id) {
+                if (edgeStore.to[id] == nodeId) computeEdgeWeights(edges[id]);
+            }
+        }
+        ++mapVersion; // 들어오는 엣지가 없어도 시간 의존 탐색(runArrivalSearch) 결과는 바뀜
+    }
+
+    // 해당 노드 진입 시 평균 신호 대기 시간 (교차로가 아니면 0)
+    double expectedLightWait(const Node* n) const {
+        if (n->type != INTERSECTION || (size_t)n->id >= signalPlans.size()) return 0.0;
+        return signalPlans[n->id].expectedWait();
+    }
+
+    // 엣지 하나의 비용 함수별 가중치 계산
+    void computeEdgeWeights(const Edge* e) {
+        for (auto& w : edgeWeights) {
+            if (w.size() < edges.size()) w.resize(edges.size());
+        }
+        double freeFlowSec = e->speedLimit > 0
+            ? e->length / e->speedLimit * 3600.0
+            : std::numeric_limits<double>::infinity();
+        edgeWeights[METRIC_DISTANCE][e->id] = e->length;
+        edgeWeights[METRIC_FREE_FLOW][e->id] = freeFlowSec;
+        edgeWeights[METRIC_LIGHT_AWARE][e->id] = freeFlowSec + expectedLightWait(e->to);
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            if (edgeWeightsInt[m].size() < edges.size()) edgeWeightsInt[m].resize(edges.size());
+            edgeWeightsInt[m][e->id] = toIntWeight(edgeWeights[m][e->id], m);
+        }
+        ++mapVersion;
+    }
+
+    // 신호 주기 등 파라미터 변경 후 전체 가중치 재계산
+    void rebuildEdgeWeights() {
+        for (Edge* e : edges) computeEdgeWeights(e);
+    }
+	//NFC 태그 ID로 노드 조회(통신) - 태그 추가 후 아직 buildNfcIndex 전이면 태그 맵에서 조회
+    Node* getNodeByNfcTag(std::string_view tagId) const {
+        if (!nfcIndexDirty && !nfcIndex.empty()) {
+            if (Node* n = nfcIndex.find(tagId)) return n;
+        }
+        else {
+            auto it = nfcTagMap.find(tagId);
+            if (it != nfcTagMap.end()) return it->second;
+        }
+        std::cerr << "[NFC Error] Unknown Tag ID: " << tagId << endl;
+        return nullptr;
+    }
+    // 정방향/역방향 CSR 인접 인덱스 구성
+    void buildRoutingIndex() {
+        size_t n = nodes.size();
+        outStart.assign(n + 1, 0);
+        inStart.assign(n + 1, 0);
+        for (size_t id = 0; id < edgeStore.size(); ++id) {
+            outStart[edgeStore.from[id] + 1]++;
+            inStart[edgeStore.to[id] + 1]++;
+        }
+        for (size_t v = 0; v < n; ++v) {
+            outStart[v + 1] += outStart[v];
+            inStart[v + 1] += inStart[v];
+        }
+        outEdgeIds.resize(edgeStore.size());
+        inEdgeIds.resize(edgeStore.size());
+        vector<int> outFill(outStart.begin(), outStart.end() - 1);
+        vector<int> inFill(inStart.begin(), inStart.end() - 1);
+        for (size_t id = 0; id < edgeStore.size(); ++id) {
+            outEdgeIds[outFill[edgeStore.from[id]]++] = (int)id;
+            inEdgeIds[inFill[edgeStore.to[id]]++] = (int)id;
+        }
+        edgePairs.build(edgeStore.from, edgeStore.to);
+        routingIndexDirty = false;
+        reachabilityDirty = true;
+    }
+
+    void buildReachability() {
+        if (routingIndexDirty) buildRoutingIndex();
+        reachability.build(nodes.size(), outStart, outEdgeIds, edgeStore.to);
+        reachabilityDirty = false;
+    }
+
+    /**
+     * @brief 맵 구성이 끝나면 호출: 낡은 인접/NFC/도달 가능 인덱스를 모두 다시 만든다
+     * 이후의 조회(reachable, findEdge, scratch 를 받는 탐색)는 const 라 여러 세션이 같은 Map 을 함께 읽을 수 있다.
+     */
+    void prepareIndexes() {
+        if (routingIndexDirty) buildRoutingIndex();
+        if (nfcIndexDirty) buildNfcIndex();
+        if (reachabilityDirty) buildReachability();
+    }
+
+    // a 에서 b 로 가는 경로가 있는지 (일방통행 반영, 탐색 없이 O(1), prepareIndexes 이후)
+    bool reachable(const Node* a, const Node* b) const {
+        return reachability.reachable(a->id, b->id);
+    }
+
+    // fromId -> toId 로 가는 엣지 ID (없으면 -1, prepareIndexes 이후)
+    int findEdge(int fromId, int toId) const {
+        return edgePairs.find(fromId, toId);
+    }
+
+    /**
+     * @brief 다익스트라 알고리즘 (metric: 최소화할 비용 함수, mode: 단방향/양방향 탐색)
+     * scratch 를 받는 탐색 함수는 모두 Map 을 읽기만 하므로 인접 인덱스가 준비된 맵이면 동시에 호출할 수 있다.
+     */
+    vector<Edge*> findPath(SearchScratch& s, Node* start, Node* end, RouteMetric metric = METRIC_DISTANCE,
+        SearchMode mode = SEARCH_FORWARD) const {
+        vector<int> edgeIds = mode == SEARCH_BIDIRECTIONAL
+            ? findPathIdsBidirectional(s, start->id, end->id, weightsFor(s, metric))
+            : mode == SEARCH_RADIX
+            ? findPathIdsRadix(s, start->id, end->id, s.overlay ? s.overlay->weightsInt(metric) : edgeWeightsInt[metric])
+            : findPathIdsForward(s, start->id, end->id, weightsFor(s, metric));
+        vector<Edge*> path;
+        path.reserve(edgeIds.size());
+        for (int id : edgeIds) path.push_back(edges[id]);
+        return path;
+    }
+
+    /**
+     * @brief a -> b 최단 도로 거리 (km, 갈 수 없으면 무한대)
+     * 손대지 않은 기본 맵이고 통제된 도로가 없으면 컴파일 시간 거리 표(DEFAULT_MAP_DISTANCE_KM)에서 O(1),
+     * 아니면 거리 기준 탐색. 혼잡(소요 시간 배율)은 거리 가중치를 바꾸지 않으므로 표를 그대로 쓴다.
+     */
+    double roadDistanceKm(SearchScratch& s, Node* a, Node* b) const {
+        if (mapVersion == defaultMapVersion && (!s.overlay || !s.overlay->anyClosed())) return DEFAULT_MAP_DISTANCE_KM[a->id][b->id];
+        vector<int> path = findPathIdsForward(s, a->id, b->id, weightsFor(s, METRIC_DISTANCE));
+        if (path.empty() && a != b) return std::numeric_limits<double>::infinity();
+        double km = 0;
+        for (int e : path) km += edgeStore.length[e];
+        return km;
+    }
+
+    // 호출자의 탐색 가중치 (s.overlay 가 있으면 도로 통제/혼잡 반영)
+    const vector<double>& weightsFor(const SearchScratch& s, RouteMetric metric) const {
+        return s.overlay ? s.overlay->weights(metric) : edgeWeights[metric];
+    }
+
+    // --- 맵을 혼자 쓸 때 (도구/벤치마크): 인접 인덱스가 낡았으면 다시 만들고 Map 의 scratch 사용
+    vector<Edge*> findPath(Node* start, Node* end, RouteMetric metric = METRIC_DISTANCE, SearchMode mode = SEARCH_FORWARD) {
+        if (routingIndexDirty) buildRoutingIndex();
+        return findPath(scratch, start, end, metric, mode);
+    }
+    Route findPathAt(Node* start, Node* end, double departSec) {
+        if (routingIndexDirty) buildRoutingIndex();
+        return findPathAt(scratch, start, end, departSec);
+    }
+    vector<Route> findRoutesFrom(Node* start, const vector<Node*>& targets, double departSec) {
+        if (routingIndexDirty) buildRoutingIndex();
+        return findRoutesFrom(scratch, start, targets, departSec);
+    }
+    vector<vector<Route>> findRouteMatrix(const vector<Node*>& sources, const vector<Node*>& targets,
+        const vector<double>& departSecs) {
+        if (routingIndexDirty) buildRoutingIndex();
+        return findRouteMatrix(scratch, sources, targets, departSecs);
+    }
+    vector<Route> findAlternativeRoutes(Node* start, Node* end, int k, RouteMetric metric = METRIC_LIGHT_AWARE) {
+        if (routingIndexDirty) buildRoutingIndex();
+        return findAlternativeRoutes(scratch, start, end, k, metric);
+    }
+
+    // 정수 가중치 + radix heap 다익스트라 (거리는 정수값을 double 에 그대로 저장)
+    vector<int> findPathIdsRadix(SearchScratch& s, int start, int end, const vector<uint32_t>& weights) const {
+        SearchWorkspace& ws = s.forward;
+        ws.reset(nodes.size());
+        ws.set(start, 0, -1);
+        ws.radix.push(0, start);
+
+        while (!ws.radix.empty()) {
+            std::pair<uint64_t, int> top = ws.radix.pop();
+            int u = top.second;
+            if ((double)top.first > ws.dist[u]) continue;
+            if (u == end) break;
+
+            for (int i = outStart[u]; i < outStart[u + 1]; ++i) {
+                int e = outEdgeIds[i];
+                if (weights[e] == INT_WEIGHT_BLOCKED) continue;
+                int v = edgeStore.to[e];
+                uint64_t nd = top.first + weights[e];
+                if ((double)nd < ws.distanceOf(v)) {
+                    ws.set(v, (double)nd, e);
+                    ws.radix.push(nd, v);
+                }
+            }
+        }
+
+        vector<int> path;
+        if (ws.distanceOf(end) == std::numeric_limits<double>::infinity()) return path;
+        for (int curr = end; curr != start; curr = edgeStore.from[ws.parentEdge[curr]]) {
+            path.push_back(ws.parentEdge[curr]);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    vector<int> findPathIdsForward(SearchScratch& s, int start, int end, const vector<double>& weights) const {
+        SearchWorkspace& ws = s.forward;
+        ws.reset(nodes.size());
+        ws.set(start, 0, -1);
+        ws.pq.push({ 0, start });
+
+        while (!ws.pq.empty()) {
+            double d = ws.pq.top().first;
+            int u = ws.pq.top().second;
+            ws.pq.pop();
+
+            if (d > ws.dist[u]) continue;
+            if (u == end) break;
+
+            for (int i = outStart[u]; i < outStart[u + 1]; ++i) {
+                int e = outEdgeIds[i];
+                int v = edgeStore.to[e];
+                double nd = d + weights[e];
+                if (nd < ws.distanceOf(v)) {
+                    ws.set(v, nd, e);
+                    ws.pq.push({ nd, v });
+                }
+            }
+        }
+
+        vector<int> path;
+        if (ws.distanceOf(end) == std::numeric_limits<double>::infinity()) return path;
+        for (int curr = end; curr != start; curr = edgeStore.from[ws.parentEdge[curr]]) {
+            path.push_back(ws.parentEdge[curr]);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    /**
+     * @brief 양방향 다익스트라 (start 에서 정방향, end 에서 역방향 인접 리스트로 동시에 탐색)
+     *
+     * 두 방향 중 큐의 최솟값이 작은 쪽을 한 단계씩 진행하고, 양쪽에서 모두 라벨이 붙은 노드 v 에 대해
+     * dF(v) + dB(v) 의 최솟값 mu 를 유지한다. 두 큐 최솟값의 합이 mu 이상이 되면 더 짧은 경로가
+     * 있을 수 없으므로 종료한다. 일방통행은 역방향 탐색에서 inEdgeIds 로 자연히 반영된다.
+     */
+    vector<int> findPathIdsBidirectional(SearchScratch& s, int start, int end, const vector<double>& weights) const {
+        const double INF = std::numeric_limits<double>::infinity();
+        SearchWorkspace& fw = s.forward;
+        SearchWorkspace& bw = s.backward;
+        fw.reset(nodes.size());
+        bw.reset(nodes.size());
+        if (start == end) return {};
+        fw.set(start, 0, -1);
+        fw.pq.push({ 0, start });
+        bw.set(end, 0, -1);
+        bw.pq.push({ 0, end });
+
+        double best = INF;
+        int meet = -1;
+        while (!fw.pq.empty() && !bw.pq.empty()) {
+            if (fw.pq.top().first + bw.pq.top().first >= best) break;
+
+            bool forward = fw.pq.top().first <= bw.pq.top().first;
+            SearchWorkspace& ws = forward ? fw : bw;
+            SearchWorkspace& other = forward ? bw : fw;
+            const vector<int>& first = forward ? outStart : inStart;
+            const vector<int>& list = forward ? outEdgeIds : inEdgeIds;
+            const vector<int>& next = forward ? edgeStore.to : edgeStore.from;
+
+            double d = ws.pq.top().first;
+            int u = ws.pq.top().second;
+            ws.pq.pop();
+            if (d > ws.dist[u]) continue;
+
+            for (int i = first[u]; i < first[u + 1]; ++i) {
+                int e = list[i];
+                int v = next[e];
+                double nd = d + weights[e];
+                if (nd < ws.distanceOf(v)) {
+                    ws.set(v, nd, e);
+                    ws.pq.push({ nd, v });
+                    double total = nd + other.distanceOf(v);
+                    if (total < best) {
+                        best = total;
+                        meet = v;
+                    }
+                }
+            }
+        }
+
+        vector<int> path;
+        if (meet < 0) return path;
+        for (int curr = meet; curr != start; curr = edgeStore.from[fw.parentEdge[curr]]) {
+            path.push_back(fw.parentEdge[curr]);
+        }
+        std::reverse(path.begin(), path.end());
+        for (int curr = meet; curr != end; curr = edgeStore.to[bw.parentEdge[curr]]) {
+            path.push_back(bw.parentEdge[curr]);
+        }
+        return path;
+    }
+
+    /**
+     * @brief 신호 주기를 반영한 시간 의존 최단 경로 (departSec 에 start 출발)
+     * @param departSec 출발 시각 (signalClock 기준, 초)
+     * @return 도착 시각이 가장 이른 경로. etaSec 은 각 교차로 도착 시점의 신호 대기를 포함
+     *
+     * 교차로 대기는 도착 시각에 대해 FIFO(늦게 도착해서 먼저 떠날 수 없음)이므로
+     * 도착 시각을 라벨로 쓰는 다익스트라로 정확한 최단 시간을 구할 수 있다.
+     */
+    Route findPathAt(SearchScratch& s, Node* start, Node* end, double departSec) const {
+        searchArrivalTimes(s.forward, weightsFor(s, METRIC_FREE_FLOW), start->id, departSec, { end->id });
+        return extractRoute(s.forward, start->id, end->id, departSec);
+    }
+
+    /**
+     * @brief 한 출발지에서 여러 목적지까지의 시간 의존 경로 (탐색 1회)
+     * @return targets 와 같은 순서의 경로 목록 (도달 불가면 found == false)
+     */
+    vector<Route> findRoutesFrom(SearchScratch& s, Node* start, const vector<Node*>& targets, double departSec) const {
+        vector<int> targetIds;
+        targetIds.reserve(targets.size());
+        for (Node* t : targets) targetIds.push_back(t->id);
+        searchArrivalTimes(s.forward, weightsFor(s, METRIC_FREE_FLOW), start->id, departSec, targetIds);
+
+        vector<Route> routes;
+        routes.reserve(targets.size());
+        for (int t : targetIds) routes.push_back(extractRoute(s.forward, start->id, t, departSec));
+        return routes;
+    }
+
+    /**
+     * @brief 여러 출발지 x 여러 목적지 경로 표 (출발지마다 탐색 1회)
+     * @param departSecs 출발지별 출발 시각 (sources 와 같은 순서)
+     * @return routes[i][j] = sources[i] -> targets[j]
+     */
+    vector<vector<Route>> findRouteMatrix(SearchScratch& s, const vector<Node*>& sources, const vector<Node*>& targets,
+        const vector<double>& departSecs) const {
+        vector<vector<Route>> routes;
+        routes.reserve(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            routes.push_back(findRoutesFrom(s, sources[i], targets, departSecs[i]));
+        }
+        return routes;
+    }
+
+    // 시간 의존 다익스트라 (라벨 = 도착 시각). targets 가 모두 확정되면 종료
+    // travelSec: 엣지별 자유 주행 시간 (기본 edgeWeights[METRIC_FREE_FLOW], 통제된 엣지는 무한대)
+    void searchArrivalTimes(SearchWorkspace& ws, const vector<double>& travelSec, int start, double departSec,
+        vector<int> targets) const {
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        runArrivalSearch(ws, travelSec, start, departSec, targets);
+    }
+
+    // searchArrivalTimes 본체 (sortedTargets: 정렬/중복 제거된 목록, 인덱스 구성 완료 상태에서 호출)
+    // Map 을 수정하지 않으므로 스레드마다 작업 공간을 따로 쓰면 동시에 호출할 수 있다.
+    void runArrivalSearch(SearchWorkspace& ws, const vector<double>& travelSec, int start, double departSec,
+        const vector<int>& sortedTargets) const {
+        const vector<int>& targets = sortedTargets;
+        size_t remaining = targets.size();
+
+        ws.reset(nodes.size());
+        ws.set(start, departSec, -1);
+        ws.km[start] = 0;
+        ws.pq.push({ departSec, start });
+
+        while (!ws.pq.empty() && remaining > 0) {
+            double t = ws.pq.top().first;
+            int u = ws.pq.top().second;
+            ws.pq.pop();
+
+            if (t > ws.dist[u]) continue;
+            if (std::binary_search(targets.begin(), targets.end(), u)) remaining--;
+
+            for (int i = outStart[u]; i < outStart[u + 1]; ++i) {
+                int e = outEdgeIds[i];
+                int v = edgeStore.to[e];
+                double tv = t + travelSec[e];
+                if (tv == std::numeric_limits<double>::infinity()) continue; // 통제된 도로
+                if (edgeStore.targetIsIntersection(e)) tv += signalPlans[v].waitAt(tv);
+                if (tv < ws.distanceOf(v)) {
+                    ws.set(v, tv, e);
+                    ws.km[v] = ws.km[u] + edgeStore.length[e];
+                    ws.pq.push({ tv, v });
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 정해진 경로를 departSec 에 출발해 따라갈 때 소요 시간 (초, 통제된 엣지가 있으면 무한대)
+     * runArrivalSearch 와 같은 모델: 엣지마다 자유 주행 시간(overlay 혼잡 반영) + 교차로 도착 시각의 실제 신호 대기.
+     * 평균 대기 가중치로 찾은 경로(대안 경로 등)를 시간 의존 경로와 같은 기준의 ETA 로 다시 잴 때 사용 (O(경로 길이)).
+     */
+    double timeRouteSec(const SearchScratch& s, const vector<int>& edgeIds, double departSec) const {
+        const vector<double>& travelSec = weightsFor(s, METRIC_FREE_FLOW);
+        double t = departSec;
+        for (int e : edgeIds) {
+            t += travelSec[e];
+            if (t == std::numeric_limits<double>::infinity()) return t;
+            if (edgeStore.targetIsIntersection(e)) t += signalPlans[edgeStore.to[e]].waitAt(t);
+        }
+        return t - departSec;
+    }
+
+    // searchArrivalTimes 결과에서 start -> end 경로 복원
+    Route extractRoute(const SearchWorkspace& ws, int start, int end, double departSec) const {
+        Route route;
+        if (ws.distanceOf(end) == std::numeric_limits<double>::infinity()) return route;
+        for (int curr = end; curr != start; curr = edgeStore.from[ws.parentEdge[curr]]) {
+            route.edgeIds.push_back(ws.parentEdge[curr]);
+        }
+        std::reverse(route.edgeIds.begin(), route.edgeIds.end());
+        RouteMetrics metrics = summarizeRoute(route.edgeIds);
+        route.distanceKm = metrics.distanceKm;
+        route.lights = metrics.lights;
+        route.etaSec = ws.distanceOf(end) - departSec;
+        route.found = true;
+        return route;
+    }
+
+    /**
+     * @brief 서로 다른 루프 없는 경로 최대 k 개 (Yen 알고리즘, 비용 오름차순)
+     * @param metric 경로 비용 (기본: 평균 신호 대기를 포함한 소요 시간)
+     *
+     * 목적지 기준 역방향 최단 경로 트리를 한 번 만들어 두고 모든 분기(spur) 탐색에서 재사용한다.
+     * - 분기 노드에서 트리 경로가 차단된 노드/엣지를 지나지 않으면 탐색 없이 그대로 사용
+     * - 아니면 트리 거리를 휴리스틱으로 쓰는 A* 로 탐색 (엣지 차단은 거리를 늘리기만 하므로 허용 가능)
+     */
+    vector<Route> findAlternativeRoutes(SearchScratch& s, Node* start, Node* end, int k,
+        RouteMetric metric = METRIC_LIGHT_AWARE) const {
+        const double INF = std::numeric_limits<double>::infinity();
+        const vector<double>& w = weightsFor(s, metric);
+        vector<Route> result;
+        if (k <= 0 || start == end) return result;
+
+        // 1. 목적지까지의 역방향 최단 경로 트리 (toEnd = s.backward)
+        SearchWorkspace& toEnd = s.backward;
+        toEnd.reset(nodes.size());
+        toEnd.set(end->id, 0, -1);
+        toEnd.pq.push({ 0, end->id });
+        while (!toEnd.pq.empty()) {
+            double d = toEnd.pq.top().first;
+            int u = toEnd.pq.top().second;
+            toEnd.pq.pop();
+            if (d > toEnd.dist[u]) continue;
+            for (int i = inStart[u]; i < inStart[u + 1]; ++i) {
+                int e = inEdgeIds[i];
+                int v = edgeStore.from[e];
+                if (d + w[e] < toEnd.distanceOf(v)) {
+                    toEnd.set(v, d + w[e], e);
+                    toEnd.pq.push({ d + w[e], v });
+                }
+            }
+        }
+        if (toEnd.distanceOf(start->id) == INF) return result;
+
+        auto treePath = [&](int from, vector<int>& out) {
+            for (int v = from; v != end->id; v = edgeStore.to[toEnd.parentEdge[v]]) out.push_back(toEnd.parentEdge[v]);
+        };
+        auto costOf = [&](const vector<int>& path) {
+            double c = 0;
+            for (int e : path) c += w[e];
+            return c;
+        };
+
+        vector<vector<int>> accepted(1);
+        treePath(start->id, accepted[0]);
+        vector<std::pair<double, vector<int>>> candidates;
+
+        vector<uint32_t>& blockedNodeStamp = s.blockedNodeStamp;
+        vector<uint32_t>& blockedEdgeStamp = s.blockedEdgeStamp;
+        uint32_t& blockStamp = s.blockStamp;
+        if (blockedNodeStamp.size() < nodes.size()) blockedNodeStamp.resize(nodes.size(), 0);
+        if (blockedEdgeStamp.size() < edges.size()) blockedEdgeStamp.resize(edges.size(), 0);
+
+        while ((int)accepted.size() < k) {
+            const vector<int>& last = accepted.back();
+            int spurNode = start->id;
+            double rootCost = 0;
+            for (size_t i = 0; i < last.size(); ++i) {
+                // 2. 차단: 같은 root 를 가진 기존 경로의 다음 엣지 + root 위의 노드(분기 노드 제외)
+                ++blockStamp;
+                for (const vector<int>& p : accepted) {
+                    if (p.size() > i && std::equal(last.begin(), last.begin() + i, p.begin())) {
+                        blockedEdgeStamp[p[i]] = blockStamp;
+                    }
+                }
+                int v = start->id;
+                for (size_t j = 0; j < i; ++j) {
+                    blockedNodeStamp[v] = blockStamp;
+                    v = edgeStore.to[last[j]];
+                }
+
+                // 3. 분기 경로: 트리 경로가 차단을 피하면 그대로, 아니면 A*
+                vector<int> spur;
+                bool treeUsable = toEnd.distanceOf(spurNode) != INF && blockedEdgeStamp[toEnd.parentEdge[spurNode]] != blockStamp;
+                for (int x = spurNode; treeUsable && x != end->id; x = edgeStore.to[toEnd.parentEdge[x]]) {
+                    if (x != spurNode && blockedNodeStamp[x] == blockStamp) treeUsable = false;
+                }
+                if (treeUsable) treePath(spurNode, spur);
+                else spur = spurSearch(s, spurNode, end->id, w);
+
+                if (!spur.empty()) {
+                    vector<int> total(last.begin(), last.begin() + i);
+                    total.insert(total.end(), spur.begin(), spur.end());
+                    bool duplicate = std::find(accepted.begin(), accepted.end(), total) != accepted.end();
+                    for (const auto& c : candidates) duplicate = duplicate || c.second == total;
+                    if (!duplicate) candidates.push_back({ rootCost + costOf(spur), total });
+                }
+                rootCost += w[last[i]];
+                spurNode = edgeStore.to[last[i]];
+            }
+            if (candidates.empty()) break;
+            auto best = std::min_element(candidates.begin(), candidates.end(),
+                [](const std::pair<double, vector<int>>& a, const std::pair<double, vector<int>>& b) { return a.first < b.first; });
+            accepted.push_back(best->second);
+            candidates.erase(best);
+        }
+
+        for (const vector<int>& path : accepted) {
+            Route route;
+            route.edgeIds = path;
+            RouteMetrics metrics = summarizeRoute(path, s.overlay);
+            route.distanceKm = metrics.distanceKm;
+            route.lights = metrics.lights;
+            route.etaSec = metrics.etaSec;
+            route.found = true;
+            result.push_back(route);
+        }
+        return result;
+    }
+
+    // 차단 표시(s.blockStamp)를 피하는 A* (휴리스틱: s.backward 의 역방향 트리 거리)
+    vector<int> spurSearch(SearchScratch& s, int from, int to, const vector<double>& w) const {
+        const double INF = std::numeric_limits<double>::infinity();
+        const SearchWorkspace& toEnd = s.backward;
+        SearchWorkspace& ws = s.forward;
+        ws.reset(nodes.size());
+        ws.set(from, 0, -1);
+        ws.pq.push({ toEnd.distanceOf(from), from });
+        bool reached = false;
+        while (!ws.pq.empty()) {
+            int u = ws.pq.top().second;
+            double f = ws.pq.top().first;
+            ws.pq.pop();
+            if (f > ws.dist[u] + toEnd.distanceOf(u)) continue;
+            if (u == to) {
+                reached = true;
+                break;
+            }
+            for (int i = outStart[u]; i < outStart[u + 1]; ++i) {
+                int e = outEdgeIds[i];
+                int v = edgeStore.to[e];
+                if (s.blockedEdgeStamp[e] == s.blockStamp || s.blockedNodeStamp[v] == s.blockStamp) continue;
+                double h = toEnd.distanceOf(v);
+                if (h == INF) continue;
+                double nd = ws.dist[u] + w[e];
+                if (nd < ws.distanceOf(v)) {
+                    ws.set(v, nd, e);
+                    ws.pq.push({ nd + h, v });
+                }
+            }
+        }
+        vector<int> path;
+        if (!reached) return path;
+        for (int curr = to; curr != from; curr = edgeStore.from[ws.parentEdge[curr]]) path.push_back(ws.parentEdge[curr]);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // 경로 지표 합산 (ETA 는 교차로 평균 신호 대기를 반영한 예상치, overlay 가 있으면 혼잡 배율 반영)
+    RouteMetrics summarizeRoute(const vector<int>& edgeIds, const RoadOverlay* overlay = nullptr) const {
+        const vector<double>& eta = overlay ? overlay->weights(METRIC_LIGHT_AWARE) : edgeWeights[METRIC_LIGHT_AWARE];
+        return edgeStore.summarize(edgeIds.data(), edgeIds.size(), eta.data());
+    }
+
+    // 맵이 차지하는 메모리 추정치 (std::map 노드는 항목마다 포인터 3개 + 색 정도로 계산)
+    size_t memoryBytes() const {
+        const size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+        size_t bytes = sizeof(*this) + arena.bytesUsed() + scratch.memoryBytes() - 2 * sizeof(SearchWorkspace);
+        bytes += (nodes.capacity() + stores.capacity() + houses.capacity()) * sizeof(Node*) + edges.capacity() * sizeof(Edge*);
+        for (const auto& entry : adj) bytes += TREE_NODE_OVERHEAD + sizeof(entry) + entry.second.capacity() * sizeof(Edge*);
+        for (const auto& entry : nfcTagMap) bytes += TREE_NODE_OVERHEAD + sizeof(entry) + entry.first.capacity();
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            bytes += edgeWeights[m].capacity() * sizeof(double) + edgeWeightsInt[m].capacity() * sizeof(uint32_t);
+        }
+        bytes += (outStart.capacity() + outEdgeIds.capacity() + inStart.capacity() + inEdgeIds.capacity()) * sizeof(int);
+        bytes += edgeStore.memoryBytes() + nfcIndex.memoryBytes() + edgePairs.memoryBytes() + reachability.memoryBytes();
+        bytes += signalPlans.capacity() * sizeof(SignalPlan);
+        return bytes;
+    }
+};
+
+
+// =================================================================
+// 3-2. 병렬 경로 표 엔진 (가게 x 집 거리/ETA 표, 배차 실험/대형 맵 분석용)
+// =================================================================
+
+/**
+ * @brief 고정 크기 스레드 풀. run(job) 은 모든 워커에서 job(workerId) 를 실행하고 끝날 때까지 기다린다.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount) {
+        for (int i = 0; i < std::max(1, threadCount); ++i) {
+            workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    int size() const { return (int)workers.size(); }
+
+    void run(const std::function<void(int)>& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        currentJob = &job;
+        pending = (int)workers.size();
+        ++generation;
+        wake.notify_all();
+        done.wait(lock, [this]() { return pending == 0; });
+        currentJob = nullptr;
+    }
+
+private:
+    vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* currentJob = nullptr;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    void workerLoop(int workerId) {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(int)>* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                job = currentJob;
+            }
+            (*job)(workerId);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+};
+
+/**
+ * @brief 출발지 x 목적지 ETA/거리 표 (TILE x TILE 타일 단위로 저장)
+ *
+ * 한 타일(32x32 float = 4KB)은 출발지 32개 묶음을 맡은 한 스레드만 쓰므로 스레드 간
+ * 캐시 라인 공유가 없고, 열(목적지) 방향으로 읽을 때도 타일 안에서 지역성이 유지된다.
+ */
+class RouteMatrix {
+public:
+    static const int TILE = 32;
+
+    void resize(int rowCount, int colCount) {
+        rows = rowCount;
+        cols = colCount;
+        tileCols = (cols + TILE - 1) / TILE;
+        size_t tileRows = (rows + TILE - 1) / TILE;
+        etaSec.assign(tileRows * tileCols * TILE * TILE, std::numeric_limits<float>::infinity());
+        distanceKm.assign(etaSec.size(), std::numeric_limits<float>::infinity());
+    }
+
+    int rowCount() const { return rows; }
+    int colCount() const { return cols; }
+    float eta(int row, int col) const { return etaSec[offset(row, col)]; }
+    float distance(int row, int col) const { return distanceKm[offset(row, col)]; }
+
+    void set(int row, int col, float eta, float km) {
+        size_t i = offset(row, col);
+        etaSec[i] = eta;
+        distanceKm[i] = km;
+    }
+
+private:
+    int rows = 0, cols = 0;
+    size_t tileCols = 0;
+    vector<float> etaSec;     // 도달 불가면 무한대
+    vector<float> distanceKm;
+
+    size_t offset(int row, int col) const {
+        size_t tile = (size_t)(row / TILE) * tileCols + (col / TILE);
+        return tile * TILE * TILE + (size_t)(row % TILE) * TILE + (col % TILE);
+    }
+};
+
+/**
+ * @brief 출발지마다 독립적인 시간 의존 SSSP 를 스레드 풀에서 병렬로 실행해 RouteMatrix 를 채운다.
+ * 스레드마다 SearchWorkspace 를 하나씩 두고 재사용하며, Map 은 읽기만 한다.
+ */
+class RouteMatrixEngine {
+public:
+    explicit RouteMatrixEngine(Map& m, int threadCount = (int)std::max(1u, std::thread::hardware_concurrency()))
+        : map(m), pool(threadCount), workspaces(pool.size()) {
+    }
+
+    int threadCount() const { return pool.size(); }
+
+    RouteMatrix compute(const vector<Node*>& sources, const vector<Node*>& targets, double departSec) {
+        if (map.routingIndexDirty) map.buildRoutingIndex();
+        vector<int> sortedTargets;
+        for (Node* t : targets) sortedTargets.push_back(t->id);
+        std::sort(sortedTargets.begin(), sortedTargets.end());
+        sortedTargets.erase(std::unique(sortedTargets.begin(), sortedTargets.end()), sortedTargets.end());
+
+        RouteMatrix matrix;
+        matrix.resize((int)sources.size(), (int)targets.size());
+        int rowBlocks = ((int)sources.size() + RouteMatrix::TILE - 1) / RouteMatrix::TILE;
+        std::atomic<int> nextBlock(0);
+
+        pool.run([&](int worker) {
+            SearchWorkspace& ws = workspaces[worker];
+            for (int block = nextBlock++; block < rowBlocks; block = nextBlock++) {
+                int rowEnd = std::min((int)sources.size(), (block + 1) * RouteMatrix::TILE);
+                for (int row = block * RouteMatrix::TILE; row < rowEnd; ++row) {
+                    map.runArrivalSearch(ws, map.edgeWeights[METRIC_FREE_FLOW], sources[row]->id, departSec, sortedTargets);
+                    for (int col = 0; col < (int)targets.size(); ++col) {
+                        int t = targets[col]->id;
+                        double arrival = ws.distanceOf(t);
+                        if (arrival != std::numeric_limits<double>::infinity()) {
+                            matrix.set(row, col, (float)(arrival - departSec), (float)ws.km[t]);
+                        }
+                    }
+                }
+            }
+        });
+        return matrix;
+    }
+
+private:
+    Map& map;
+    ThreadPool pool;
+    vector<SearchWorkspace> workspaces;
+};
+
+// -----------------------------------------------------------------
+// 맵 파일 변환 (텍스트 -> Map -> 바이너리 .dmap)
+// -----------------------------------------------------------------
+
+bool parseNodeType(const string& text, NodeType& type) {
+    if (text == "STORE") type = STORE;
+    else if (text == "HOUSE") type = HOUSE;
+    else if (text == "INTERSECTION") type = INTERSECTION;
+    else if (text == "STREET") type = STREET;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief 텍스트 맵 설명을 읽어 Map 구성
+ *
+ * 한 줄에 한 항목, '#' 이후는 주석:
+ *   node <id> <STORE|HOUSE|INTERSECTION|STREET> <이름>   (id 는 0부터 순서대로)
+ *   edge <from> <to> <길이 km> <제한속도 km/h> [oneway]
+ *   tag <NFC 태그 ID> <노드 id>
+ *   signal <노드 id> <주기 초> <오프셋 초> <녹색 비율>
+ */
+bool loadMapText(std::istream& in, Map& m) {
+    string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        std::istringstream ss(line);
+        string kind;
+        if (!(ss >> kind)) continue;
+
+        bool ok = false;
+        if (kind == "node") {
+            int id;
+            string typeText, name;
+            NodeType type;
+            if (ss >> id >> typeText && parseNodeType(typeText, type) && id == (int)m.nodes.size()) {
+                std::getline(ss >> std::ws, name);
+                m.addNode(name, type);
+                ok = true;
+            }
+        }
+        else if (kind == "edge") {
+            int from, to;
+            double len, sl;
+            string flag;
+            if (ss >> from >> to >> len >> sl && from >= 0 && to >= 0) {
+                ss >> flag;
+                m.addEdge(from, to, len, sl, flag == "oneway");
+                ok = from < (int)m.nodes.size() && to < (int)m.nodes.size();
+            }
+        }
+        else if (kind == "tag") {
+            string tagId;
+            int nodeId;
+            if (ss >> tagId >> nodeId && nodeId >= 0 && nodeId < (int)m.nodes.size()) {
+                m.addNfcTag(tagId, nodeId);
+                ok = true;
+            }
+        }
+        else if (kind == "signal") {
+            int nodeId;
+            double cycle, offset, green;
+            if (ss >> nodeId >> cycle >> offset >> green && nodeId >= 0 && nodeId < (int)m.nodes.size() && cycle > 0) {
+                m.setSignalPlan(nodeId, cycle, offset, green);
+                ok = true;
+            }
+        }
+        if (!ok) {
+            std::cerr << "[Map Error] Line " << lineNo << ": cannot parse '" << line << "'" << endl;
+            return false;
+        }
+    }
+    m.prepareIndexes();
+    return true;
+}
+
+/**
+ * @brief Map 을 바이너리 맵 파일(.dmap)로 저장
+ */
+bool writeMapFile(const Map& m, const string& path) {
+    auto align8 = [](uint64_t offset) { return (offset + 7) & ~uint64_t(7); };
+
+    MapFileHeader h = {};
+    std::memcpy(h.magic, MAP_FILE_MAGIC, sizeof(h.magic));
+    h.version = MAP_FILE_VERSION;
+    h.nodeCount = (uint32_t)m.nodes.size();
+    h.edgeCount = (uint32_t)m.edges.size();
+    h.tagCount = (uint32_t)m.nfcTagMap.size();
+
+    // 문자열 풀 (노드 이름 + NFC 태그)
+    string pool;
+    vector<MapFileNode> fileNodes(h.nodeCount);
+    for (const Node* n : m.nodes) {
+        MapFileNode& fn = fileNodes[n->id];
+        fn = {};
+        fn.nameOffset = (uint32_t)pool.size();
+        fn.nameLength = (uint32_t)n->name.size();
+        fn.type = (uint32_t)n->type;
+        SignalPlan plan = (size_t)n->id < m.signalPlans.size() ? m.signalPlans[n->id] : SignalPlan();
+        fn.signalCycleSec = plan.cycleSec;
+        fn.signalOffsetSec = plan.offsetSec;
+        fn.signalGreenRatio = plan.greenRatio;
+        pool += n->name;
+    }
+    vector<MapFileTag> fileTags;
+    fileTags.reserve(h.tagCount);
+    for (const auto& kv : m.nfcTagMap) { // std::map 이므로 이미 태그 문자열 순으로 정렬됨
+        MapFileTag ft = {};
+        ft.tagOffset = (uint32_t)pool.size();
+        ft.tagLength = (uint32_t)kv.first.size();
+        ft.nodeId = (uint32_t)kv.second->id;
+        fileTags.push_back(ft);
+        pool += kv.first;
+    }
+
+    // 엣지 + 노드별 출발 엣지 인덱스 (CSR)
+    vector<MapFileEdge> fileEdges(h.edgeCount);
+    vector<uint32_t> outStart(h.nodeCount + 1, 0);
+    for (const Edge* e : m.edges) {
+        MapFileEdge& fe = fileEdges[e->id];
+        fe = {};
+        fe.from = (uint32_t)e->from->id;
+        fe.to = (uint32_t)e->to->id;
+        fe.length = e->length;
+        fe.speedLimit = e->speedLimit;
+        fe.isOneWay = e->isOneWay ? 1 : 0;
+        outStart[e->from->id + 1]++;
+    }
+    for (uint32_t i = 0; i < h.nodeCount; ++i) outStart[i + 1] += outStart[i];
+    vector<uint32_t> outEdges(h.edgeCount);
+    vector<uint32_t> fill(outStart.begin(), outStart.end() - 1);
+    for (const Edge* e : m.edges) outEdges[fill[e->from->id]++] = (uint32_t)e->id;
+
+    h.nodesOffset = align8(sizeof(MapFileHeader));
+    h.edgesOffset = align8(h.nodesOffset + fileNodes.size() * sizeof(MapFileNode));
+    h.tagsOffset = align8(h.edgesOffset + fileEdges.size() * sizeof(MapFileEdge));
+    h.outStartOffset = align8(h.tagsOffset + fileTags.size() * sizeof(MapFileTag));
+    h.outEdgesOffset = align8(h.outStartOffset + outStart.size() * sizeof(uint32_t));
+    h.stringPoolOffset = align8(h.outEdgesOffset + outEdges.size() * sizeof(uint32_t));
+    h.stringPoolSize = pool.size();
+    h.fileSize = align8(h.stringPoolOffset + pool.size());
+
+    vector<char> buffer(h.fileSize, 0);
+    auto put = [&](uint64_t offset, const void* data, size_t bytes) {
+        if (bytes) std::memcpy(buffer.data() + offset, data, bytes);
+    };
+    put(0, &h, sizeof(h));
+    put(h.nodesOffset, fileNodes.data(), fileNodes.size() * sizeof(MapFileNode));
+    put(h.edgesOffset, fileEdges.data(), fileEdges.size() * sizeof(MapFileEdge));
+    put(h.tagsOffset, fileTags.data(), fileTags.size() * sizeof(MapFileTag));
+    put(h.outStartOffset, outStart.data(), outStart.size() * sizeof(uint32_t));
+    put(h.outEdgesOffset, outEdges.data(), outEdges.size() * sizeof(uint32_t));
+    put(h.stringPoolOffset, pool.data(), pool.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.write(buffer.data(), (std::streamsize)buffer.size())) {
+        std::cerr << "[Map Error] Cannot write map file: " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// =================================================================
+// 3-3. 실시간 길안내 (NFC 체크포인트마다 경로 확인, 이탈 시에만 재탐색)
+// =================================================================
+
+/**
+ * @brief 목적지(가게/집)별 역방향 최단 경로 트리 캐시
+ *
+ * 목적지는 stores/houses 로 정해져 있으므로 목적지마다 트리를 한 번 만들어 두면
+ * "임의 노드에서 목적지까지 비용/다음 엣지" 가 배열 조회가 된다.
+ * 트리는 만들 때의 Map::mapVersion 을 기억하고, 맵이 바뀐 뒤 처음 조회될 때 다시 만든다.
+ * 인접 인덱스가 준비된 맵(prepareIndexes)에서 사용.
+ * 여러 세션이 함께 쓰는 맵은 reserveAll 로 목적지 자리만 잡아 두고, find 가 처음 찾을 때 목적지마다 한 번만 만든다
+ * (트리 전체를 미리 만들면 O((가게+집) x 노드) 시간/메모리라 큰 맵에서는 쓸 수 없음).
+ */
+struct DestinationTree {
+    int destination = -1;
+    uint64_t version = 0;
+    std::atomic<bool> built{ false }; // 구성 완료 (release 로 게시, 이후 cost/nextEdge 는 읽기만)
+    std::once_flag once;              // reserveAll 캐시에서 슬롯마다 한 번만 구성
+    vector<float> cost;   // 목적지까지 비용 (LIGHT_AWARE 초, 갈 수 없으면 무한대)
+    vector<int> nextEdge; // 목적지 쪽으로 가는 다음 엣지 (목적지 자신 또는 갈 수 없으면 -1)
+};
+
+class DestinationTreeCache {
+public:
+    explicit DestinationTreeCache(const Map& m) : map(m) {
+    }
+
+    bool covers(const Node* n) const { return n->type == STORE || n->type == HOUSE; }
+
+    // 목적지 트리 (처음 조회 또는 맵 변경 후면 구성)
+    const DestinationTree& treeTo(const Node* dest) {
+        if (slotOf.size() < map.nodes.size()) slotOf.resize(map.nodes.size(), -1);
+        int& slot = slotOf[dest->id];
+        if (slot < 0) {
+            slot = (int)trees.size();
+            trees.emplace_back();
+            trees.back().destination = dest->id;
+        }
+        DestinationTree& tree = trees[slot];
+        if (!tree.built.load(std::memory_order_relaxed) || tree.version != map.mapVersion) build(tree, ws);
+        return tree;
+    }
+
+    /**
+     * @brief 최신 트리 조회 (없거나 맵이 바뀌었으면 nullptr)
+     * reserveAll 로 자리를 잡아 둔 목적지는 처음 조회할 때 구성한다. 여러 스레드가 같은 목적지를 동시에 찾아도
+     * 한 스레드만 만들고 나머지는 기다렸다가 같은 트리를 받는다 (다른 목적지는 동시에 구성 가능).
+     */
+    const DestinationTree* find(const Node* dest) const {
+        if (dest->id >= (int)slotOf.size() || slotOf[dest->id] < 0) return nullptr;
+        DestinationTree& tree = trees[slotOf[dest->id]];
+        if (!tree.built.load(std::memory_order_acquire)) {
+            if (!lazy) return nullptr;
+            std::call_once(tree.once, [&] {
+                thread_local SearchWorkspace threadWs; // 구성은 스레드마다 따로 (멤버 ws 는 treeTo 전용)
+                build(tree, threadWs);
+            });
+        }
+        return tree.version == map.mapVersion ? &tree : nullptr;
+    }
+
+    /**
+     * @brief 기본 가중치로 만든 트리가 overlay 를 적용해도 최단 경로 트리인지 (바뀐 엣지 수만큼만 확인)
+     * - 트리 엣지가 비싸지거나 막히면 그 엣지를 지나는 노드들의 경로가 바뀔 수 있음
+     * - 트리 밖 엣지가 싸져서 지름길이 되면 (새 비용 + 도착 노드 비용 < 출발 노드 비용) 경로가 바뀜
+     * 그 밖의 변경(트리 밖 엣지가 비싸지거나 트리 엣지가 싸짐)은 트리 모양을 바꾸지 않는다.
+     */
+    bool validUnder(const DestinationTree& tree, const RoadOverlay& overlay) const {
+        const vector<double>& baseW = map.edgeWeights[METRIC_LIGHT_AWARE];
+        const vector<double>& w = overlay.weights(METRIC_LIGHT_AWARE);
+        for (int e : overlay.changedEdges()) {
+            int from = map.edgeStore.from[e], to = map.edgeStore.to[e];
+            if (w[e] > baseW[e]) {
+                if (tree.nextEdge[from] == e) return false;
+            }
+            else if (w[e] < baseW[e]) {
+                double viaEdge = (double)tree.cost[to] + w[e];
+                if (viaEdge < (double)tree.cost[from] * (1.0 - 1e-6)) return false; // float 반올림 여유
+            }
+        }
+        return true;
+    }
+
+    double costTo(const Node* from, const Node* dest) { return treeTo(dest).cost[from->id]; }
+    int nextEdgeTo(const Node* from, const Node* dest) { return treeTo(dest).nextEdge[from->id]; }
+
+    // 모든 가게/집 트리를 미리 구성 (작은 맵, 벤치마크)
+    void buildAll() {
+        for (Node* n : map.stores) treeTo(n);
+        for (Node* n : map.houses) treeTo(n);
+    }
+
+    // 모든 가게/집 자리만 잡아 두고 트리는 find 가 처음 찾을 때 구성 (공유하기 전에 한 번 호출, 이후 맵은 바뀌지 않아야 함)
+    void reserveAll() {
+        slotOf.assign(map.nodes.size(), -1);
+        trees.clear();
+        for (const vector<Node*>* list : { &map.stores, &map.houses }) {
+            for (const Node* n : *list) {
+                if (slotOf[n->id] >= 0) continue;
+                slotOf[n->id] = (int)trees.size();
+                trees.emplace_back();
+                trees.back().destination = n->id;
+            }
+        }
+        lazy = true;
+    }
+
+    // 트리 메모리 해제 (다음 조회 때 다시 구성)
+    void clear() {
+        trees.clear();
+        slotOf.clear();
+        lazy = false;
+    }
+
+    size_t destinationCount() const { return trees.size(); }
+    // 지금까지 구성된 트리 수 (reserveAll 캐시는 다른 스레드가 구성하는 중에도 읽을 수 있음)
+    size_t treeCount() const {
+        size_t count = 0;
+        for (const DestinationTree& t : trees) count += t.built.load(std::memory_order_acquire);
+        return count;
+    }
+    int buildCount() const { return builds.load(std::memory_order_relaxed); }
+
+    size_t memoryBytes() const {
+        size_t bytes = slotOf.capacity() * sizeof(int) + trees.size() * sizeof(DestinationTree);
+        for (const DestinationTree& t : trees) {
+            if (!t.built.load(std::memory_order_acquire)) continue;
+            bytes += t.cost.capacity() * sizeof(float) + t.nextEdge.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+private:
+    void build(DestinationTree& tree, SearchWorkspace& ws) const {
+        const vector<double>& w = map.edgeWeights[METRIC_LIGHT_AWARE];
+        ws.reset(map.nodes.size());
+        ws.set(tree.destination, 0, -1);
+        ws.pq.push({ 0, tree.destination });
+        while (!ws.pq.empty()) {
+            double d = ws.pq.top().first;
+            int u = ws.pq.top().second;
+            ws.pq.pop();
+            if (d > ws.dist[u]) continue;
+            for (int i = map.inStart[u]; i < map.inStart[u + 1]; ++i) {
+                int e = map.inEdgeIds[i];
+                int from = map.edgeStore.from[e];
+                if (d + w[e] < ws.distanceOf(from)) {
+                    ws.set(from, d + w[e], e);
+                    ws.pq.push({ d + w[e], from });
+                }
+            }
+        }
+        tree.cost.resize(map.nodes.size());
+        tree.nextEdge.resize(map.nodes.size());
+        for (size_t v = 0; v < map.nodes.size(); ++v) {
+            tree.cost[v] = (float)ws.distanceOf((int)v);
+            tree.nextEdge[v] = ws.stamp[v] == ws.currentStamp ? ws.parentEdge[v] : -1;
+        }
+        tree.version = map.mapVersion;
+        tree.built.store(true, std::memory_order_release);
+        builds.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const Map& map;
+    vector<int> slotOf; // 노드 ID -> trees 위치 (-1: 아직 없음)
+    mutable std::deque<DestinationTree> trees; // find 가 reserveAll 슬롯을 채움 (emplace_back 해도 주소 유지)
+    SearchWorkspace ws;
+    mutable std::atomic<int> builds{ 0 };
+    bool lazy = false; // reserveAll 이후: find 가 없는 트리를 구성
+};
+
+/**
+ * @brief 현재 목적지(가게/집)까지의 경로와 목적지 기준 역방향 최단 경로 트리를 유지
+ *
+ * 가게/집이 목적지면 DestinationTreeCache 의 트리를 그대로 쓴다 (목적지마다 처음 한 번 구성된 뒤로는 읽기만 하므로 세션끼리 공유 가능).
+ * 도로 통제 오버레이가 있으면 그 트리가 오버레이에서도 유효할 때만 쓰고, 아니면 오버레이 가중치로 직접 키운다.
+ * 그 밖의 목적지는 목적지에서 역방향 Dijkstra 를 "필요한 노드가 확정될 때까지만" 진행해 두고,
+ * 경로 이탈 시 멈춘 지점부터 이어서 키운다 (목적지가 바뀌기 전까지 처음부터 다시 하지 않음).
+ * 트리가 확정한 노드의 경로는 트리를 따라가기만 하면 되므로 추가 탐색이 없다.
+ */
+class Navigator {
+public:
+    explicit Navigator(const Map& m, const DestinationTreeCache* treeCache = nullptr, const RoadOverlay* roadOverlay = nullptr)
+        : map(m), cache(treeCache), overlay(roadOverlay) {
+    }
+
+    bool active() const { return destination != nullptr; }
+    Node* target() const { return destination; }
+    const Route& route() const { return current; }
+    int rerouteCount() const { return reroutes; }
+
+    size_t memoryBytes() const {
+        return sizeof(*this) + tree.memoryBytes() - sizeof(SearchWorkspace) + current.edgeIds.capacity() * sizeof(int)
+            + (settled.capacity() + routeStamp.capacity()) * sizeof(uint32_t) + routePos.capacity() * sizeof(int)
+            + etaAfter.capacity() * sizeof(double);
+    }
+
+    // 마지막 체크포인트에서 경로상 다음 엣지 (경로가 없거나 도착했으면 -1)
+    int currentEdge() const {
+        return destination && progress < (int)current.edgeIds.size() ? current.edgeIds[progress] : -1;
+    }
+
+    /**
+     * @brief 현재 엣지를 edgeFraction (0~1) 만큼 달린 위치에서 목적지까지 예상 시간 (O(1))
+     * 남은 엣지 구간의 주행 시간 + 엣지 끝 교차로 평균 대기 + 이후 경로의 예상 시간 (도로 통제/혼잡 반영)
+     */
+    double etaFrom(double edgeFraction) const {
+        int e = currentEdge();
+        if (e < 0) return 0;
+        const vector<double>& travel = overlay ? overlay->weights(METRIC_FREE_FLOW) : map.edgeWeights[METRIC_FREE_FLOW];
+        const vector<double>& total = overlay ? overlay->weights(METRIC_LIGHT_AWARE) : map.edgeWeights[METRIC_LIGHT_AWARE];
+        double f = std::min(std::max(edgeFraction, 0.0), 1.0);
+        return (1.0 - f) * travel[e] + (total[e] - travel[e]) + etaAfter[progress + 1];
+    }
+
+    // 새 목적지로 안내 시작 (이전 트리는 버림)
+    void setDestination(Node* from, Node* dest) {
+        destination = dest;
+        restartTree();
+        planFrom(from->id);
+    }
+
+    void clear() {
+        destination = nullptr;
+        current = Route();
+    }
+
+    /**
+     * @brief NFC 체크포인트 도착 처리
+     * @return 경로를 새로 만들었으면 true (route() 로 새 경로 확인)
+     *
+     * 현재 경로에서 지난 지점 이후의 노드면 최적 경로 위에 있는 것이므로 O(1) 로 진행 위치만 갱신.
+     * (태그를 건너뛰고 경로 앞쪽 노드에서 읽혀도 경로 위로 본다)
+     * 맵이나 도로 통제가 바뀌었으면 경로 위에 있어도 새로 찾는다.
+     */
+    bool onCheckpoint(Node* at) {
+        if (!destination) return false;
+        int v = at->id;
+        if (plannedVersion != map.mapVersion || plannedOverlay != overlayVersion()) {
+            restartTree();
+        }
+        else if (routeStamp[v] == routeGeneration && routePos[v] >= progress) {
+            progress = routePos[v];
+            return false;
+        }
+        planFrom(v);
+        ++reroutes;
+        return true;
+    }
+
+    /**
+     * @brief 도로 통제/혼잡이 바뀐 직후 호출 (at: 마지막 체크포인트)
+     * @return 남은 경로가 바뀌었으면 true. 남은 경로에 바뀐 엣지가 없고 트리도 유효하면 재탐색 결과도 같다.
+     */
+    bool onOverlayChanged(Node* at) {
+        if (!destination || plannedOverlay == overlayVersion()) return false;
+        vector<int> remaining(current.edgeIds.begin() + std::min(progress, (int)current.edgeIds.size()), current.edgeIds.end());
+        restartTree();
+        planFrom(at->id);
+        if (current.edgeIds == remaining) return false;
+        ++reroutes;
+        return true;
+    }
+
+private:
+    uint64_t overlayVersion() const { return overlay ? overlay->version() : 0; }
+
+    void restartTree() {
+        plannedVersion = map.mapVersion;
+        plannedOverlay = overlayVersion();
+        cached = cache ? cache->find(destination) : nullptr;
+        if (cached && overlay && !overlay->empty() && !cache->validUnder(*cached, *overlay)) cached = nullptr;
+        if (cached) return;
+        tree.reset(map.nodes.size());
+        if (settled.size() < map.nodes.size()) settled.resize(map.nodes.size(), 0);
+        if (tree.currentStamp == 1) std::fill(settled.begin(), settled.end(), 0); // 세대 번호가 한 바퀴 돎
+        tree.set(destination->id, 0, -1);
+        tree.pq.push({ 0, destination->id });
+    }
+
+    // 트리를 v 가 확정될 때까지만 이어서 키움
+    void growTreeUntil(int v) {
+        const vector<double>& w = overlay ? overlay->weights(METRIC_LIGHT_AWARE) : map.edgeWeights[METRIC_LIGHT_AWARE];
+        while (settled[v] != tree.currentStamp && !tree.pq.empty()) {
+            double d = tree.pq.top().first;
+            int u = tree.pq.top().second;
+            tree.pq.pop();
+            if (settled[u] == tree.currentStamp || d > tree.dist[u]) continue;
+            settled[u] = tree.currentStamp;
+            for (int i = map.inStart[u]; i < map.inStart[u + 1]; ++i) {
+                int e = map.inEdgeIds[i];
+                int from = map.edgeStore.from[e];
+                if (d + w[e] < tree.distanceOf(from)) {
+                    tree.set(from, d + w[e], e);
+                    tree.pq.push({ d + w[e], from });
+                }
+            }
+        }
+    }
+
+    // v 에서 목적지까지 트리를 따라 경로 구성
+    void planFrom(int v) {
+        current = Route();
+        progress = 0;
+        if (routeStamp.size() < map.nodes.size()) {
+            routeStamp.resize(map.nodes.size(), 0);
+            routePos.resize(map.nodes.size());
+        }
+        if (++routeGeneration == 0) {
+            std::fill(routeStamp.begin(), routeStamp.end(), 0);
+            routeGeneration = 1;
+        }
+
+        if (cached) {
+            const DestinationTree& t = *cached;
+            if (t.nextEdge[v] < 0 && v != destination->id) return; // 목적지에 갈 수 없는 위치
+            for (int x = v; x != destination->id; x = map.edgeStore.to[t.nextEdge[x]]) {
+                current.edgeIds.push_back(t.nextEdge[x]);
+            }
+        }
+        else {
+            growTreeUntil(v);
+            if (settled[v] != tree.currentStamp) return;
+            for (int x = v; x != destination->id; x = map.edgeStore.to[tree.parentEdge[x]]) {
+                current.edgeIds.push_back(tree.parentEdge[x]);
+            }
+        }
+
+        routeStamp[v] = routeGeneration;
+        routePos[v] = 0;
+        for (size_t i = 0; i < current.edgeIds.size(); ++i) {
+            int x = map.edgeStore.to[current.edgeIds[i]];
+            routeStamp[x] = routeGeneration;
+            routePos[x] = (int)i + 1;
+        }
+        RouteMetrics metrics = map.summarizeRoute(current.edgeIds, overlay);
+        current.distanceKm = metrics.distanceKm;
+        current.lights = metrics.lights;
+        current.etaSec = metrics.etaSec;
+        current.found = true;
+
+        // etaAfter[i] = 경로의 i 번째 엣지부터 목적지까지 예상 시간 (etaFrom 용)
+        const vector<double>& eta = overlay ? overlay->weights(METRIC_LIGHT_AWARE) : map.edgeWeights[METRIC_LIGHT_AWARE];
+        etaAfter.assign(current.edgeIds.size() + 1, 0.0);
+        for (size_t i = current.edgeIds.size(); i-- > 0;) etaAfter[i] = etaAfter[i + 1] + eta[current.edgeIds[i]];
+    }
+
+    const Map& map;
+    const DestinationTreeCache* cache;
+    const RoadOverlay* overlay;
+    const DestinationTree* cached = nullptr; // 현재 목적지의 캐시 트리 (없으면 tree 를 직접 키움)
+    Node* destination = nullptr;
+    uint64_t plannedVersion = 0;
+    uint64_t plannedOverlay = 0;
+    SearchWorkspace tree;     // 역방향 트리: dist = 목적지까지 비용, parentEdge = 목적지 쪽 다음 엣지
+    vector<uint32_t> settled; // settled[v] == tree.currentStamp 이면 확정
+    Route current;
+    vector<uint32_t> routeStamp; // 현재 경로 위의 노드 표시 (세대 번호)
+    vector<int> routePos;        // 현재 경로에서 노드의 순서
+    vector<double> etaAfter;     // 경로 위치별 남은 예상 시간
+    uint32_t routeGeneration = 0;
+    int progress = 0;
+    int reroutes = 0;
+};
+
+
+// =================================================================
+// 3-4. 절차적 맵 생성 (대형 맵 벤치마크용, 같은 설정 + 시드면 항상 같은 맵)
+// =================================================================
+
+/**
+ * @brief 맵 생성용 난수 (splitmix64)
+ * std 분포 클래스는 표준 라이브러리 구현마다 결과가 달라서, 플랫폼이 달라도 같은 맵이 나오도록 직접 구현
+ */
+class MapGenRandom {
+public:
+    explicit MapGenRandom(uint64_t seed) : state(seed) {
+    }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); } // [0, 1)
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+    uint32_t below(uint32_t n) { return (uint32_t)(((next() >> 32) * n) >> 32); } // [0, n)
+
+private:
+    uint64_t state;
+};
+
+struct SpeedLimitShare {
+    double kmh;
+    double weight; // 상대 비율
+};
+
+/**
+ * @brief 생성할 맵 설정
+ *
+ * 노드는 rows x cols 격자 칸에 하나씩 놓이고 ID = 행 * cols + 열 (공간적으로 가까운 ID 를 질의에 쓰기 쉬움).
+ * - GRID    : 칸 중심에 정렬, 도로 길이 = 칸 간 직선 거리
+ * - ORGANIC : 칸 안에서 위치를 흔들고 도로를 조금씩 굽힘 (길이 = 직선 거리 x 1.0~1.25)
+ * 도로는 무작위 신장 트리(모든 노드 연결) -> 나머지 이웃 도로 -> 2칸 이내 지름길 순으로 roadCount 까지 추가.
+ */
+struct MapGenConfig {
+    enum Layout { GRID, ORGANIC };
+
+    Layout layout = GRID;
+    uint64_t seed = 1;
+    int nodeCount = 10000;
+    int cols = 0;         // 한 행의 노드 수 (0 이면 sqrt(nodeCount))
+    size_t roadCount = 0; // 도로 수 (양방향 도로 1개 = 1, 0 이면 상하좌우 이웃 도로 전부)
+    double blockKm = 0.2; // 칸 간격
+    double storeRatio = 0.01;
+    double houseRatio = 0.075;
+    double intersectionRatio = 0.1;
+    double oneWayFraction = 0.05;
+    vector<SpeedLimitShare> speedLimits = { { 30, 0.2 }, { 50, 0.5 }, { 60, 0.2 }, { 70, 0.1 } };
+    bool withNfcTags = true; // 노드마다 "NFC_<노드 ID>" 태그
+
+    static MapGenConfig grid(int rows, int cols, uint64_t seed = 1) {
+        MapGenConfig cfg;
+        cfg.seed = seed;
+        cfg.nodeCount = rows * cols;
+        cfg.cols = cols;
+        return cfg;
+    }
+};
+
+/**
+ * @brief 설정대로 빈 Map 에 노드/엣지/신호/NFC 태그 생성
+ */
+bool generateMap(Map& m, const MapGenConfig& cfg) {
+    if (!m.nodes.empty() || cfg.nodeCount <= 0) {
+        std::cerr << "[Map Error] generateMap requires an empty map and a positive node count." << endl;
+        return false;
+    }
+    double speedWeightSum = 0;
+    for (const SpeedLimitShare& s : cfg.speedLimits) speedWeightSum += s.weight;
+    if (speedWeightSum <= 0) {
+        std::cerr << "[Map Error] generateMap needs at least one speed limit with a positive weight." << endl;
+        return false;
+    }
+
+    MapGenRandom rng(cfg.seed);
+    const int n = cfg.nodeCount;
+    const int cols = cfg.cols > 0 ? cfg.cols : std::max(1, (int)std::ceil(std::sqrt((double)n)));
+    const bool organic = cfg.layout == MapGenConfig::ORGANIC;
+
+    // 1. 노드 (종류, 위치, 교차로 신호)
+    vector<double> x(n), y(n);
+    m.nodes.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        double roll = rng.uniform();
+        NodeType type = roll < cfg.storeRatio ? STORE
+            : roll < cfg.storeRatio + cfg.houseRatio ? HOUSE
+            : roll < cfg.storeRatio + cfg.houseRatio + cfg.intersectionRatio ? INTERSECTION
+            : STREET;
+        m.addNode("N" + std::to_string(i), type);
+        double jitter = organic ? 0.35 : 0.0;
+        x[i] = (i % cols + rng.uniform(-jitter, jitter)) * cfg.blockKm;
+        y[i] = (i / cols + rng.uniform(-jitter, jitter)) * cfg.blockKm;
+        if (type == INTERSECTION) {
+            const double cycles[] = { 60, 90, 120 };
+            double cycle = cycles[rng.below(3)];
+            m.setSignalPlan(i, cycle, rng.uniform(0, cycle), rng.uniform(0.4, 0.6));
+        }
+    }
+
+    // 2. 도로 선택: 이웃 도로를 섞은 뒤 신장 트리 도로 먼저, 그다음 나머지
+    vector<std::pair<int, int>> neighbors;
+    for (int i = 0; i < n; ++i) {
+        if (i % cols + 1 < cols && i + 1 < n) neighbors.push_back({ i, i + 1 });
+        if (i + cols < n) neighbors.push_back({ i, i + cols });
+    }
+    for (size_t i = neighbors.size(); i > 1; --i) std::swap(neighbors[i - 1], neighbors[rng.below((uint32_t)i)]);
+
+    vector<int> parent(n);
+    for (int i = 0; i < n; ++i) parent[i] = i;
+    auto findRoot = [&](int v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    vector<std::pair<int, int>> roads, rest;
+    for (const auto& road : neighbors) {
+        int a = findRoot(road.first), b = findRoot(road.second);
+        if (a != b) {
+            parent[a] = b;
+            roads.push_back(road);
+        }
+        else {
+            rest.push_back(road);
+        }
+    }
+    size_t target = cfg.roadCount ? cfg.roadCount : neighbors.size();
+    if (roads.size() > target) roads.resize(target); // 신장 트리보다 적으면 일부 구역이 끊김
+    for (size_t i = 0; i < rest.size() && roads.size() < target; ++i) roads.push_back(rest[i]);
+
+    // 3. 목표가 이웃 도로보다 많으면 2칸 이내 지름길 (대각선 포함) 추가
+    std::unordered_set<uint64_t> used;
+    auto pairKey = [](int a, int b) { return (uint64_t(std::min(a, b)) << 32) | uint32_t(std::max(a, b)); };
+    for (const auto& road : roads) used.insert(pairKey(road.first, road.second));
+    for (size_t attempts = 0; roads.size() < target && attempts < target * 20; ++attempts) {
+        int a = (int)rng.below(n);
+        int dr = (int)rng.below(5) - 2, dc = (int)rng.below(5) - 2;
+        int r = a / cols + dr, c = a % cols + dc;
+        if (c < 0 || c >= cols || r < 0) continue;
+        int b = r * cols + c;
+        if (b >= n || b == a || !used.insert(pairKey(a, b)).second) continue;
+        roads.push_back({ a, b });
+    }
+
+    // 4. 도로 속성 (길이, 제한속도, 일방통행) 후 엣지 추가
+    m.edges.reserve(roads.size() * 2);
+    m.arena.reserve(n * (sizeof(Node) + 8) + roads.size() * 2 * sizeof(Edge));
+    for (const auto& road : roads) {
+        int a = road.first, b = road.second;
+        double len = std::hypot(x[a] - x[b], y[a] - y[b]) * (organic ? rng.uniform(1.0, 1.25) : 1.0);
+        double pick = rng.uniform() * speedWeightSum;
+        double speed = cfg.speedLimits.back().kmh;
+        for (const SpeedLimitShare& s : cfg.speedLimits) {
+            if (pick < s.weight) {
+                speed = s.kmh;
+                break;
+            }
+            pick -= s.weight;
+        }
+        bool oneWay = rng.uniform() < cfg.oneWayFraction;
+        if (oneWay && rng.below(2)) std::swap(a, b);
+        m.addEdge(a, b, std::max(len, 0.01), speed, oneWay);
+    }
+
+    if (cfg.withNfcTags) {
+        for (int i = 0; i < n; ++i) m.addNfcTag("NFC_" + std::to_string(i), i);
+    }
+    m.prepareIndexes();
+    return true;
+}
+
+
+// =================================================================
+// 3-5. 맵 공유와 스냅샷 게시 (여러 게임이 맵 한 벌을 함께 읽고, 게임을 멈추지 않고 새 맵으로 교체)
+// =================================================================
+
+/**
+ * @brief 여러 게임 세션이 함께 읽는 맵 (만든 뒤로는 바꾸지 않음)
+ *
+ * 토폴로지, 엣지 가중치, NFC 표, 인접/도달 가능 인덱스(Map)는 한 번만 만들고,
+ * 가게/집 목적지 트리는 어느 세션이든 그 목적지를 처음 안내할 때 한 번만 만든다 (게시 비용에 트리 구성이 들지 않음).
+ * 세션마다 달라지는 신호 진행과 탐색 작업 공간은 MapSession 이 따로 가진다.
+ */
+class SharedMap {
+public:
+    explicit SharedMap(std::shared_ptr<Map> source)
+        : mapPtr(prepared(std::move(source))), destinationTrees(*mapPtr) {
+        destinationTrees.reserveAll();
+        intersectionSlot.assign(mapPtr->nodes.size(), -1);
+        for (const Node* n : mapPtr->nodes) {
+            if (n->type == INTERSECTION && n->id < (int)mapPtr->signalPlans.size()) {
+                intersectionSlot[n->id] = (int)intersections.size();
+                intersections.push_back(n->id);
+            }
+        }
+    }
+
+    const Map& map() const { return *mapPtr; }
+    const DestinationTreeCache& trees() const { return destinationTrees; }
+
+    // 노드 ID -> 세션 신호 배열 위치 (교차로가 아니면 -1)
+    int signalSlotOf(int nodeId) const { return intersectionSlot[nodeId]; }
+    const vector<int>& signalNodes() const { return intersections; }
+
+    size_t memoryBytes() const {
+        return sizeof(*this) + mapPtr->memoryBytes() + destinationTrees.memoryBytes()
+            + (intersectionSlot.capacity() + intersections.capacity()) * sizeof(int);
+    }
+
+private:
+    std::shared_ptr<const Map> mapPtr;
+    DestinationTreeCache destinationTrees;
+    vector<int> intersectionSlot;
+    vector<int> intersections; // 신호 배열 위치 -> 노드 ID
+
+    static std::shared_ptr<const Map> prepared(std::shared_ptr<Map> m) {
+        m->prepareIndexes();
+        return m;
+    }
+};
+
+// 기본 맵(buildMap)으로 만든 공유 맵 (처음 요청될 때 프로세스에서 한 번만 구성)
+std::shared_ptr<const SharedMap> defaultSharedMap() {
+    static const std::shared_ptr<const SharedMap> shared = [] {
+        auto m = std::make_shared<Map>();
+        m->buildMap();
+        return std::make_shared<const SharedMap>(m);
+    }();
+    return shared;
+}
+
+// 경로 캐시 적중/미스 집계 (MapSession::routeCacheStats)
+struct RouteCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;     // 용량 초과로 버린 항목
+    uint64_t invalidations = 0; // 맵이 바뀌거나 엣지가 싸져서 전부 버린 횟수
+    uint64_t edgeInvalidations = 0; // 지나는 엣지가 막히거나 비싸져서 버린 항목 수
+    size_t entries = 0;
+    size_t capacity = 0;
+
+    double hitRate() const { return hits + misses ? (double)hits / (hits + misses) : 0.0; }
+};
+
+/**
+ * @brief (출발 노드, 도착 노드, 비용 함수) -> 경로 결과 LRU 캐시
+ *
+ * 값은 findAlternativeRoutes 결과 (경로 엣지 ID, 거리, 신호 수, 소요 시간). 결과는 맵과 도로 통제에만
+ * 의존한다. Map::mapVersion 이 바뀌면 조회 전에 전부 버리고, 도로 통제는 MapSession 이 엣지마다 알려 준다.
+ * - 엣지가 막히거나 비싸짐: 그 엣지를 지나는 경로가 든 항목만 버림 (다른 경로들의 비용과 순서는 그대로)
+ * - 엣지가 싸짐 (통제 해제, 혼잡 완화): 어느 경로가 새로 짧아질지 모르므로 전부 버림
+ * 항목은 고정 크기 슬롯 배열 + 인덱스 연결 리스트라 조회/삽입/교체가 O(1) 이다.
+ */
+class RouteCache {
+public:
+    explicit RouteCache(size_t capacity) : maxEntries(capacity) {
+        stats.capacity = capacity;
+    }
+
+    /**
+     * @brief 캐시 조회 (k: 요청한 경로 수)
+     * 같은 키를 k 개 이상 요청해 두었거나, 요청보다 적게 찾아 경로가 더 없는 것이 확인된 항목이면 적중.
+     */
+    bool find(int from, int to, int metric, int k, uint64_t mapVersion, vector<Route>& out) {
+        sync(mapVersion);
+        auto it = index.find(keyOf(from, to, metric));
+        if (it == index.end()) {
+            ++stats.misses;
+            return false;
+        }
+        Slot& slot = slots[it->second];
+        if (slot.k < k && (int)slot.routes.size() >= slot.k) {
+            ++stats.misses;
+            return false;
+        }
+        moveToFront(it->second);
+        out.assign(slot.routes.begin(), slot.routes.begin() + std::min((size_t)k, slot.routes.size()));
+        ++stats.hits;
+        return true;
+    }
+
+    void insert(int from, int to, int metric, int k, uint64_t mapVersion, const vector<Route>& routes) {
+        if (maxEntries == 0) return;
+        sync(mapVersion);
+        uint64_t key = keyOf(from, to, metric);
+        auto it = index.find(key);
+        int s;
+        if (it != index.end()) {
+            s = it->second;
+            unlink(s);
+        }
+        else if (slots.size() < maxEntries) { // 슬롯은 쓰는 만큼만 만듦 (콜이 없는 세션은 비용 없음)
+            s = (int)slots.size();
+            slots.emplace_back();
+            index[key] = s;
+        }
+        else { // 가장 오래 안 쓴 항목 교체
+            s = tail;
+            unlink(s);
+            index.erase(slots[s].key);
+            index[key] = s;
+            ++stats.evictions;
+        }
+        slots[s].key = key;
+        slots[s].k = k;
+        slots[s].routes = routes;
+        pushFront(s);
+    }
+
+    void clear() {
+        index.clear();
+        slots.clear();
+        head = tail = -1;
+    }
+
+    // 엣지가 막히거나 비싸짐: 그 엣지를 지나는 경로가 든 항목만 버림 (O(항목 x 경로 길이))
+    void invalidateEdge(int edgeId) {
+        for (int s = (int)slots.size() - 1; s >= 0; --s) {
+            bool uses = false;
+            for (const Route& r : slots[s].routes) {
+                if (std::find(r.edgeIds.begin(), r.edgeIds.end(), edgeId) != r.edgeIds.end()) {
+                    uses = true;
+                    break;
+                }
+            }
+            if (!uses) continue;
+            remove(s);
+            ++stats.edgeInvalidations;
+        }
+    }
+
+    // 엣지가 싸짐: 전부 버림
+    void invalidateAll() {
+        if (slots.empty()) return;
+        clear();
+        ++stats.invalidations;
+    }
+
+    RouteCacheStats statistics() const {
+        RouteCacheStats s = stats;
+        s.entries = slots.size();
+        return s;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(*this) + slots.capacity() * sizeof(Slot)
+            + index.bucket_count() * sizeof(void*) + index.size() * (sizeof(std::pair<uint64_t, int>) + sizeof(void*));
+        for (const Slot& slot : slots) {
+            bytes += slot.routes.capacity() * sizeof(Route);
+            for (const Route& r : slot.routes) bytes += r.edgeIds.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        int k = 0;
+        vector<Route> routes;
+        int prev = -1, next = -1; // LRU 순서 (head = 최근 사용)
+    };
+    size_t maxEntries;
+    vector<Slot> slots;
+    std::unordered_map<uint64_t, int> index;
+    int head = -1, tail = -1;
+    uint64_t cachedMapVersion = 0;
+    RouteCacheStats stats;
+
+    // 노드 ID 30비트씩 + 비용 함수 4비트
+    static uint64_t keyOf(int from, int to, int metric) {
+        return ((uint64_t)from << 34) | ((uint64_t)to << 4) | (uint64_t)metric;
+    }
+
+    void sync(uint64_t mapVersion) {
+        if (mapVersion == cachedMapVersion) return;
+        invalidateAll();
+        cachedMapVersion = mapVersion;
+    }
+
+    // 슬롯 s 제거 (마지막 슬롯을 그 자리로 옮겨 배열을 빈틈없이 유지)
+    void remove(int s) {
+        unlink(s);
+        index.erase(slots[s].key);
+        int last = (int)slots.size() - 1;
+        if (s != last) {
+            Slot& moved = slots[last];
+            if (moved.prev >= 0) slots[moved.prev].next = s;
+            else head = s;
+            if (moved.next >= 0) slots[moved.next].prev = s;
+            else tail = s;
+            index[moved.key] = s;
+            slots[s] = std::move(moved);
+        }
+        slots.pop_back();
+    }
+
+    void unlink(int s) {
+        Slot& slot = slots[s];
+        if (slot.prev >= 0) slots[slot.prev].next = slot.next;
+        else head = slot.next;
+        if (slot.next >= 0) slots[slot.next].prev = slot.prev;
+        else tail = slot.prev;
+        slot.prev = slot.next = -1;
+    }
+
+    void pushFront(int s) {
+        slots[s].prev = -1;
+        slots[s].next = head;
+        if (head >= 0) slots[head].prev = s;
+        head = s;
+        if (tail < 0) tail = s;
+    }
+
+    void moveToFront(int s) {
+        if (s == head) return;
+        unlink(s);
+        pushFront(s);
+    }
+};
+
+/**
+ * @brief 게임 세션 하나가 공유 맵 위에서 따로 갖는 가변 상태
+ *
+ * - 신호 진행: 세션 시작 시각 기준 위상, 변경 예약(타이머 휠), 변경 기록. 배열은 교차로 수만큼만 둔다.
+ * - 탐색 작업 공간: 처음 탐색할 때 노드 수만큼 커진다.
+ * - 도로 통제/혼잡 오버레이: 첫 이벤트 때 가중치 배열을 복사하고, 이후로는 바뀐 엣지만 고친다.
+ * - 대안 경로 캐시: 같은 가게 -> 집 경로를 콜 생성 때마다 다시 찾지 않도록 최근 결과를 보관한다.
+ * 맵은 SharedMap 을 읽기만 하므로 세션을 몇 개 만들어도 맵은 한 벌이다.
+ */
+class MapSession {
+public:
+    static constexpr double LIGHT_TICK_SEC = 0.1;
+    static constexpr size_t ROUTE_CACHE_CAPACITY = 256;
+
+    explicit MapSession(std::shared_ptr<const SharedMap> sharedMap)
+        : shared(std::move(sharedMap)), map(shared->map()), routeCache(ROUTE_CACHE_CAPACITY) {
+        overlay.bind(map.edgeWeights, map.edgeWeightsInt);
+        scratch.overlay = &overlay;
     }
-};
+    MapSession(const MapSession&) = delete; // scratch 가 overlay 주소를 가리킴
+    MapSession& operator=(const MapSession&) = delete;
 
-class Map {
-public:
-    vector<Node*> nodes;
-    vector<Edge*> edges;
-    map<Node*, vector<Edge*>> adj;
-    vector<Node*> stores;
-    vector<Node*> houses;
-    map<string, Node*> nfcTagMap;
+    const SharedMap& sharedMap() const { return *shared; }
 
-    ~Map() {
-        for (auto n : nodes) delete n;
-        for (auto e : edges) delete e;
+    // 신호 기준 시각(signalEpoch)부터 현재까지 경과 시간 (초)
+    double signalClock() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - signalEpoch).count();
     }
 
-    void buildMap() {
-        // 1. 노드 생성 (총 16개)
-        nodes.push_back(new Node(0, "S1: 뜨끈국밥", STORE));
-        nodes.push_back(new Node(1, "S2: 바삭치킨", STORE));
-        nodes.push_back(new Node(2, "S3: 달콤케이크", STORE));
-        nodes.push_back(new Node(3, "S4: 시원음료", STORE));
-
-        nodes.push_back(new Node(4, "H1: 101동", HOUSE));
-        nodes.push_back(new Node(5, "H2: 102동", HOUSE));
-        nodes.push_back(new Node(6, "H3: 201동", HOUSE));
-        nodes.push_back(new Node(7, "H4: 202동", HOUSE));
-        nodes.push_back(new Node(8, "H5: 301동", HOUSE));
-        nodes.push_back(new Node(9, "H6: 302동", HOUSE));
-
-        nodes.push_back(new Node(10, "I1: 사거리A", INTERSECTION));
-        nodes.push_back(new Node(11, "I2: 사거리B", INTERSECTION));
-        nodes.push_back(new Node(12, "I3: 삼거리C", INTERSECTION));
-        nodes.push_back(new Node(13, "I4: 삼거리D", INTERSECTION));
-
-        nodes.push_back(new Node(14, "ST1: 중앙로", STREET));
-        nodes.push_back(new Node(15, "ST2: 골목길", STREET));
-
-        for (int i = 0; i < 4; ++i) stores.push_back(nodes[i]);
-        for (int i = 4; i < 10; ++i) houses.push_back(nodes[i]);
-
-        // NFC 태그 ID 매핑
-        nfcTagMap["NFC_S1"] = nodes[0];
-        nfcTagMap["NFC_S2"] = nodes[1];
-        nfcTagMap["NFC_S3"] = nodes[2];
-        nfcTagMap["NFC_S4"] = nodes[3];
-        nfcTagMap["NFC_H1"] = nodes[4];
-        nfcTagMap["NFC_H2"] = nodes[5];
-        nfcTagMap["NFC_H3"] = nodes[6];
-        nfcTagMap["NFC_H4"] = nodes[7];
-        nfcTagMap["NFC_H5"] = nodes[8];
-        nfcTagMap["NFC_H6"] = nodes[9];
-        nfcTagMap["NFC_I1"] = nodes[10];
-        nfcTagMap["NFC_I2"] = nodes[11];
-        nfcTagMap["NFC_I3"] = nodes[12];
-        nfcTagMap["NFC_I4"] = nodes[13];
-        nfcTagMap["NFC_ST1"] = nodes[14];
-        nfcTagMap["NFC_ST2"] = nodes[15];
-
-        // 2. 엣지(도로) 생성
-        addEdge(0, 14, 0.2, 40); // S1 <-> ST1
-        addEdge(14, 10, 0.3, 50); // ST1 <-> I1
-        addEdge(1, 10, 0.4, 50); // S2 <-> I1
-        addEdge(10, 11, 1.0, 60); // I1 <-> I2
-        addEdge(10, 12, 1.2, 60); // I1 <-> I3
-        addEdge(2, 15, 0.3, 40); // S3 <-> ST2
-        addEdge(15, 11, 0.3, 50); // ST2 <-> I2
-        addEdge(3, 12, 0.7, 50); // S4 <-> I3
-        addEdge(11, 13, 1.1, 70); // I2 <-> I4 (고속)
-        addEdge(12, 13, 1.3, 70); // I3 <-> I4 (고속)
-        addEdge(11, 4, 0.3, 30); // I2 <-> H1 (스쿨존)
-        addEdge(11, 5, 0.4, 30); // I2 <-> H2
-        addEdge(12, 6, 0.5, 40); // I3 <-> H3
-        addEdge(12, 7, 0.4, 40); // I3 <-> H4
-        addEdge(13, 8, 0.8, 50); // I4 <-> H5
-        addEdge(13, 9, 0.9, 50); // I4 <-> H6
-        addEdge(4, 5, 0.2, 30, true); // H1 -> H2 (일방통행)
+    // 모든 교차로의 현재 신호를 설정하고 첫 신호 변경을 예약
+    void startTrafficLights() {
+        std::lock_guard<std::mutex> lock(lightMutex);
+        startLightsLocked();
     }
 
-    void addEdge(int fromId, int toId, double len, double sl, bool oneWay = false) {
-        if (fromId >= nodes.size() || toId >= nodes.size()) {
-            std::cerr << "[Map Error] Node ID " << fromId << " or " << toId << " is out of bounds." << endl;
-            return;
+    //신호등 업데이트(통신) - 이번 틱에 실제로 바뀌는 신호만 처리 (타이머 id = 신호 배열 위치)
+    // 게임 루프 스레드에서 호출. 신호 상태/기록은 lightMutex 로 보호 (이벤트 스레드가 wasGreenAt 으로 읽음)
+    // 알림은 잠금 안에서 모아 두기만 하고 잠금을 푼 뒤 보냄 (전송이 느려도 이벤트 스레드의 위반 판정이 기다리지 않음)
+    void updateTrafficLights() {
+        lightNotices.clear();
+        {
+            std::lock_guard<std::mutex> lock(lightMutex);
+            if (!lightsStarted) startLightsLocked();
+            uint64_t nowTick = (uint64_t)(signalClock() / LIGHT_TICK_SEC);
+            lightTimers.advance(nowTick, [this](int slot, uint64_t tick) {
+                double t = tick * LIGHT_TICK_SEC;
+                setLightState(slot, t, planOf(slot).isGreenAt(t));
+                scheduleNextLightChange(slot, t);
+                lightNotices.push_back({ shared->signalNodes()[slot], green[slot] != 0,
+                    (nextLightChangeTick[slot] - tick) * LIGHT_TICK_SEC });
+            });
         }
-        Node* from = nodes[fromId];
-        Node* to = nodes[toId];
-        Edge* e1 = new Edge(from, to, len, sl, oneWay);
-        edges.push_back(e1);
-        adj[from].push_back(e1);
 
-        if (!oneWay) {
-            Edge* e2 = new Edge(to, from, len, sl, oneWay);
-            edges.push_back(e2);
-            adj[to].push_back(e2);
+        // (통신) 앱과 RC카에 신호 변경 알림
+        for (const LightNotice& notice : lightNotices) {
+            std::stringstream ss;
+            ss << "{\"light\":\"" << map.nodes[notice.nodeId]->name << "\", \"nodeId\":" << notice.nodeId
+                << ", \"state\":\"" << (notice.green ? "green" : "red") << "\""
+                << ", \"nextChangeIn\":" << std::fixed << std::setprecision(1) << notice.nextInSec << "}";
+            sendJsonToApp(ss.str());
+            sendLightStateToRasPi(notice.nodeId, notice.green);
         }
     }
-    //신호등 업데이트(통신)
-    void updateTrafficLights() {
-        for (Node* n : nodes) {
-            if (n->type == INTERSECTION) {
-                // 1분에서 10초마다 신호 변경
-            }
+
+    // 현재 신호 (교차로가 아니면 true)
+    bool isGreen(const Node* n) const {
+        int slot = shared->signalSlotOf(n->id);
+        if (slot < 0) return true;
+        std::lock_guard<std::mutex> lock(lightMutex);
+        return slot >= (int)green.size() || green[slot];
+    }
+
+    /**
+     * @brief t 시점(signalClock 기준)에 해당 교차로 신호가 녹색이었는지 (교차로가 아니면 true)
+     * 변경 기록으로 판정하고, 기록 범위보다 오래된 시각이면 신호 주기 모델로 계산
+     */
+    bool wasGreenAt(const Node* n, double t) const {
+        int slot = shared->signalSlotOf(n->id);
+        if (slot < 0) return true;
+        bool isGreen;
+        {
+            std::lock_guard<std::mutex> lock(lightMutex);
+            if (slot < (int)signalHistory.size() && signalHistory[slot].stateAt(t, isGreen)) return isGreen;
         }
+        return planOf(slot).isGreenAt(t);
     }
-	//NFC 태그 ID로 노드 조회(통신)
-    Node* getNodeByNfcTag(const string& tagId) {
-        if (nfcTagMap.count(tagId)) {
-            return nfcTagMap.at(tagId);
+
+    const RoadOverlay& roadOverlay() const { return overlay; }
+
+    /**
+     * @brief from - to 사이 도로(양방향 엣지 모두)의 통제/혼잡 설정
+     * @param timeFactor 0 이하면 통행 금지, 1 이면 정상, 그 밖에는 소요 시간 배율
+     * @return 바뀐 엣지 수 (두 노드 사이에 도로가 없으면 0)
+     */
+    int setRoadCondition(int fromId, int toId, double timeFactor) {
+        int changedCount = 0;
+        for (int a : { fromId, toId }) {
+            int b = a == fromId ? toId : fromId;
+            for (int i = map.outStart[a]; i < map.outStart[a + 1]; ++i) {
+                int e = map.outEdgeIds[i];
+                if (map.edgeStore.to[e] != b) continue;
+                EdgeWeightsBefore before(overlay, e);
+                overlay.setClosed(e, timeFactor <= 0);
+                overlay.setFactor(e, timeFactor > 0 ? timeFactor : 1.0);
+                onEdgeChanged(before);
+                ++changedCount;
+            }
         }
-        std::cerr << "[NFC Error] Unknown Tag ID: " << tagId << endl;
-        return nullptr;
+        return changedCount;
     }
-    //다익스트라 알고리즘
-    vector<Edge*> findPath(Node* start, Node* end) {
-        map<Node*, double> dist;
-        map<Node*, Edge*> cameFromEdge;
-        priority_queue<std::pair<double, Node*>,
-            vector<std::pair<double, Node*>>,
-            std::greater<std::pair<double, Node*>>> pq;
 
-        for (Node* n : nodes) {
-            dist[n] = std::numeric_limits<double>::infinity();
+    // 모든 도로 통제/혼잡 해제 (바뀐 엣지가 없으면 경로 캐시도 그대로)
+    void clearRoadConditions() {
+        vector<EdgeWeightsBefore> before;
+        for (int e : overlay.changedEdges()) before.emplace_back(overlay, e);
+        overlay.clear();
+        for (const EdgeWeightsBefore& b : before) onEdgeChanged(b);
+    }
+
+    // 노드 통제 (노드로 들어오는 모든 엣지 통행 금지/해제, 이미 노드에 있는 라이더는 빠져나갈 수 있음)
+    int setNodeClosed(int nodeId, bool isClosed) {
+        for (int i = map.inStart[nodeId]; i < map.inStart[nodeId + 1]; ++i) {
+            EdgeWeightsBefore before(overlay, map.inEdgeIds[i]);
+            overlay.setClosed(map.inEdgeIds[i], isClosed);
+            onEdgeChanged(before);
         }
+        return map.inStart[nodeId + 1] - map.inStart[nodeId];
+    }
 
-        dist[start] = 0;
-        pq.push({ 0, start });
-        cameFromEdge[start] = nullptr;
+    // 공유 맵 탐색 (이 세션의 작업 공간과 도로 통제 사용)
+    vector<Route> findRoutesFrom(Node* start, const vector<Node*>& targets, double departSec) {
+        return map.findRoutesFrom(scratch, start, targets, departSec);
+    }
+    double roadDistanceKm(Node* a, Node* b) { return map.roadDistanceKm(scratch, a, b); }
+    double timeRouteSec(const Route& r, double departSec) const { return map.timeRouteSec(scratch, r.edgeIds, departSec); }
+
+    // 대안 경로 (경로 캐시를 먼저 확인하고, 없으면 찾아서 저장)
+    vector<Route> findAlternativeRoutes(Node* start, Node* end, int k, RouteMetric metric = METRIC_LIGHT_AWARE) {
+        vector<Route> routes;
+        if (routeCache.find(start->id, end->id, metric, k, map.mapVersion, routes)) return routes;
+        routes = map.findAlternativeRoutes(scratch, start, end, k, metric);
+        routeCache.insert(start->id, end->id, metric, k, map.mapVersion, routes);
+        return routes;
+    }
 
-        while (!pq.empty()) {
-            double d = pq.top().first;
-            Node* u = pq.top().second;
-            pq.pop();
+    RouteCacheStats routeCacheStats() const { return routeCache.statistics(); }
 
-            if (d > dist[u]) continue;
-            if (u == end) break;
+    // 이벤트 스레드(운영 지표)에서 호출: 신호 상태는 루프 스레드가 바꾸므로 lightMutex 를 잡고 읽음
+    size_t memoryBytes() const {
+        size_t lightBytes;
+        {
+            std::lock_guard<std::mutex> lock(lightMutex);
+            lightBytes = lightTimers.memoryBytes() + green.capacity() + nextLightChangeTick.capacity() * sizeof(uint64_t)
+                + signalHistory.capacity() * sizeof(SignalHistory);
+        }
+        return sizeof(*this) - sizeof(TimerWheel) - sizeof(SearchScratch) - sizeof(RoadOverlay) - sizeof(RouteCache)
+            + lightBytes + scratch.memoryBytes() + overlay.memoryBytes() + routeCache.memoryBytes();
+    }
 
-            for (Edge* e : adj[u]) {
-                Node* v = e->to;
-                double weight = e->length;
-                if (dist[v] > dist[u] + weight) {
-                    dist[v] = dist[u] + weight;
-                    cameFromEdge[v] = e;
-                    pq.push({ dist[v], v });
-                }
-            }
+private:
+    std::shared_ptr<const SharedMap> shared;
+    const Map& map;
+    std::chrono::steady_clock::time_point signalEpoch = std::chrono::steady_clock::now();
+    mutable std::mutex lightMutex; // 아래 신호 상태 보호 (루프 스레드가 갱신, 이벤트 스레드가 위반 판정에 읽음)
+    TimerWheel lightTimers;
+    vector<char> green;                   // 신호 배열 위치별 현재 신호
+    vector<uint64_t> nextLightChangeTick; // 위치별 다음 변경 틱
+    vector<SignalHistory> signalHistory;  // 위치별 최근 신호 변경 기록
+    bool lightsStarted = false;
+    // 이번 틱 신호 변경 알림 (updateTrafficLights 를 부르는 루프 스레드만 사용, 틱마다 재사용)
+    struct LightNotice {
+        int nodeId;
+        bool green;
+        double nextInSec;
+    };
+    vector<LightNotice> lightNotices;
+    RoadOverlay overlay;
+    SearchScratch scratch;
+    RouteCache routeCache;
+
+    // 오버레이를 고치기 전 엣지 가중치 (비용 함수별)
+    struct EdgeWeightsBefore {
+        int edge;
+        double weight[METRIC_COUNT];
+        EdgeWeightsBefore(const RoadOverlay& o, int e) : edge(e) {
+            for (int m = 0; m < METRIC_COUNT; ++m) weight[m] = o.weights(m)[e];
+        }
+    };
+
+    // 엣지 하나가 바뀐 뒤 경로 캐시 갱신 (어느 비용 함수에서든 싸졌으면 전부, 비싸지기만 했으면 그 엣지를 쓰는 항목만)
+    void onEdgeChanged(const EdgeWeightsBefore& before) {
+        bool cheaper = false, costlier = false;
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            double w = overlay.weights(m)[before.edge];
+            cheaper |= w < before.weight[m];
+            costlier |= w > before.weight[m];
         }
+        if (cheaper) routeCache.invalidateAll();
+        else if (costlier) routeCache.invalidateEdge(before.edge);
+    }
 
-        vector<Edge*> path;
-        Node* curr = end;
-        while (curr != start) {
-            Edge* e = cameFromEdge[curr];
-            if (!e) return {};
-            path.push_back(e);
-            curr = e->from;
+    const SignalPlan& planOf(int slot) const { return map.signalPlans[shared->signalNodes()[slot]]; }
+
+    // startTrafficLights 본체 (lightMutex 를 잡은 상태에서 호출)
+    void startLightsLocked() {
+        double t = signalClock();
+        size_t count = shared->signalNodes().size();
+        lightTimers.currentTick = (uint64_t)(t / LIGHT_TICK_SEC);
+        green.assign(count, 1);
+        nextLightChangeTick.assign(count, 0);
+        signalHistory.assign(count, SignalHistory());
+        for (int slot = 0; slot < (int)count; ++slot) {
+            setLightState(slot, t, planOf(slot).isGreenAt(t));
+            scheduleNextLightChange(slot, t);
         }
-        std::reverse(path.begin(), path.end());
-        return path;
+        lightsStarted = true;
+    }
+
+    // 신호 상태 변경 + 변경 기록
+    void setLightState(int slot, double t, bool isGreen) {
+        green[slot] = isGreen ? 1 : 0;
+        signalHistory[slot].record(t, isGreen);
+    }
+
+    void scheduleNextLightChange(int slot, double t) {
+        double changeAt = planOf(slot).nextChangeAt(t);
+        uint64_t tick = (uint64_t)std::ceil(changeAt / LIGHT_TICK_SEC - 1e-9); // 부동소수 오차 보정
+        nextLightChangeTick[slot] = tick;
+        lightTimers.schedule(slot, tick);
+    }
+};
+
+/**
+ * @brief 최신 맵 스냅샷 게시/획득 (RCU 방식)
+ *
+ * 게시된 맵은 SharedMap 으로 감싸 더 이상 바꾸지 않는다. 새 맵은 별도 객체로 만들어 publish 하고,
+ * 읽는 쪽은 version() (원자 정수 1개) 으로 변경 여부만 확인하다가 바뀌었을 때 acquire 로 shared_ptr 를 얻는다.
+ * 읽기 경로에는 뮤텍스가 없고, 이전 스냅샷은 마지막 shared_ptr 가 사라질 때 해제된다.
+ */
+class MapRegistry {
+public:
+    // 새 스냅샷 게시, 게시 버전 반환 (인덱스/목적지 트리는 잠그기 전에 구성, 게시자끼리만 뮤텍스로 직렬화)
+    uint64_t publish(std::shared_ptr<Map> next) {
+        auto shared = std::make_shared<const SharedMap>(std::move(next));
+        std::lock_guard<std::mutex> lock(publishMutex);
+        std::shared_ptr<const SharedMap> previous = std::atomic_load(&current);
+        if (previous) retired.push_back(previous);
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+            [](const std::weak_ptr<const SharedMap>& w) { return w.expired(); }), retired.end());
+        std::atomic_store(&current, std::move(shared));
+        uint64_t v = latestVersion.load() + 1;
+        latestVersion.store(v, std::memory_order_release);
+        return v;
+    }
+
+    // 현재 스냅샷 (outVersion 에 그 버전). 게시와 겹치면 한 버전 늦게 받을 수 있으나 다음 확인 때 따라잡음
+    std::shared_ptr<const SharedMap> acquire(uint64_t& outVersion) const {
+        outVersion = latestVersion.load(std::memory_order_acquire);
+        return std::atomic_load(&current);
+    }
+
+    uint64_t version() const { return latestVersion.load(std::memory_order_acquire); }
+
+    // 교체됐지만 아직 누군가 쓰고 있는 이전 스냅샷 수
+    size_t retiredAliveCount() {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        size_t alive = 0;
+        for (const auto& w : retired) alive += w.expired() ? 0 : 1;
+        return alive;
     }
+
+private:
+    std::shared_ptr<const SharedMap> current;
+    std::atomic<uint64_t> latestVersion{ 0 };
+    std::mutex publishMutex;
+    vector<std::weak_ptr<const SharedMap>> retired;
 };
 
 
@@ -517,6 +3845,112 @@ struct Call {
     }
 };
 
+/**
+ * @brief 주행 속도 샘플로 과속 판정 (히스테리시스 + 디바운스)
+ *
+ * - 제한속도 + marginKmh 를 넘는 상태가 debounceSec 동안 이어져야 위반 1회 (순간 튐 무시)
+ * - 한 번 위반하면 제한속도 - releaseKmh 아래로 내려와야 다음 위반을 다시 센다 (경계 근처 진동 무시)
+ * 샘플마다 비교와 누적만 하므로 kHz 텔레메트리에서도 할당이 없다.
+ */
+class SpeedMonitor {
+public:
+    double marginKmh = 5.0;
+    double releaseKmh = 3.0;
+    double debounceSec = 1.0;
+    double maxGapSec = 1.0; // 샘플 간격이 이보다 길면 (통신 끊김) 연속 구간으로 보지 않음
+
+    // 현재 주행 중인 도로의 제한속도 (0 이하 = 모름, 판정 안 함)
+    void setLimit(double limitKmh) {
+        if (limitKmh == limit) return;
+        limit = limitKmh;
+        overSec = 0;
+        latched = false;
+    }
+
+    double currentLimit() const { return limit; }
+
+    // 속도 샘플 처리, 위반이 새로 확정되면 true
+    bool onSample(double speedKmh, double dtSec) {
+        if (limit <= 0) return false;
+        // 통신 끊김: 끊기기 전 과속 시간만 버림 (확정 상태는 유지, 끊김 동안 계속 과속이면 같은 위반으로 봄)
+        if (dtSec > maxGapSec) overSec = 0;
+        if (latched) {
+            if (speedKmh < limit - releaseKmh) latched = false;
+            return false;
+        }
+        if (speedKmh <= limit + marginKmh) {
+            overSec = 0;
+            return false;
+        }
+        overSec += dtSec > maxGapSec ? 0.0 : dtSec; // 끊김 직후 샘플은 구간 길이를 모르므로 0 부터 시작
+        if (overSec < debounceSec) return false;
+        overSec = 0;
+        latched = true;
+        return true;
+    }
+
+private:
+    double limit = 0;
+    double overSec = 0;
+    bool latched = false;
+};
+
+/**
+ * @brief NFC 체크포인트 사이 위치 추정 (추측 항법)
+ *
+ * 체크포인트에서 "안내 경로의 다음 엣지 시작점"으로 위치를 확정하고, 주행 데이터 샘플마다 속도를
+ * 적분해 그 엣지 위 진행 거리만 늘린다 (샘플당 O(1)). 다음 체크포인트를 읽기 전에는 엣지 끝을
+ * 넘지 않는다 (교차로 신호 대기 중일 수 있고, 어느 엣지로 나갔는지는 태그로만 확정).
+ * 앱 전송은 reportIntervalSec 마다 한 번으로 제한한다.
+ */
+class DeadReckoning {
+public:
+    double maxGapSec = 1.0;         // 샘플 간격이 이보다 길면 (통신 끊김) 새 속도로만 적분
+    double reportIntervalSec = 1.0; // 위치 추정 전송 최소 간격
+
+    // 체크포인트(엣지 시작 노드)에서 위치 확정 (edgeId < 0: 안내 경로 없음, 추정 안 함)
+    void restart(int edgeId, double edgeLengthKm) {
+        edge = edgeId;
+        lengthKm = edgeLengthKm;
+        traveledKm = 0;
+        lastSpeedKmh = -1;
+    }
+
+    // 경로만 다시 찾음 (같은 엣지를 계속 달리면 진행 거리 유지)
+    void follow(int edgeId, double edgeLengthKm) {
+        if (edgeId != edge) restart(edgeId, edgeLengthKm);
+    }
+
+    /**
+     * @brief 주행 데이터 샘플 반영 (사다리꼴 적분)
+     * @return 이번 샘플에서 위치 추정을 앱에 보낼 차례면 true
+     */
+    bool onSample(double speedKmh, double dtSec) {
+        if (edge < 0) return false;
+        speedKmh = std::max(speedKmh, 0.0);
+        double avgKmh = lastSpeedKmh < 0 || dtSec > maxGapSec ? speedKmh : (lastSpeedKmh + speedKmh) / 2;
+        traveledKm = std::min(traveledKm + avgKmh * dtSec / 3600.0, lengthKm);
+        lastSpeedKmh = speedKmh;
+
+        sinceReportSec += dtSec;
+        if (sinceReportSec + 1e-9 < reportIntervalSec) return false; // 0.1초 샘플 10개 합이 1.0 보다 약간 작아도 전송
+        sinceReportSec = 0;
+        return true;
+    }
+
+    bool tracking() const { return edge >= 0; }
+    int currentEdge() const { return edge; }
+    double distanceOnEdgeKm() const { return traveledKm; }
+    double edgeFraction() const { return lengthKm > 0 ? traveledKm / lengthKm : 1.0; }
+
+private:
+    int edge = -1;
+    double lengthKm = 0;
+    double traveledKm = 0;
+    double lastSpeedKmh = -1; // 체크포인트 이후 첫 샘플이면 음수
+    double sinceReportSec = 0;
+};
+
 class Player {
 public:
     string name;
@@ -544,7 +3978,7 @@ public:
         cout << " [알림] " << food->name << "을 픽업했습니다. (현재 품질: 100.0)\n";
 
         // (통신) 앱으로 "배달지로 이동하세요" 메시지 전송
-        string jsonMsg = "{\"status\":\"navigate_to_house\", \"houseName\":\"" + destination->name + "\"}";
+        string jsonMsg = "{\"status\":\"navigate_to_house\", \"houseName\":\"" + string(destination->name) + "\"}";
         sendJsonToApp(jsonMsg);
     }
 
@@ -582,8 +4016,15 @@ public:
 
 class Game {
 public:
-    Map map;
+    // 공유 맵 위의 이 게임 상태 (신호 진행, 탐색 공간). 교체는 메인(이벤트) 스레드에서만, 게임 루프 스레드는 atomic_load 로 읽음
+    std::shared_ptr<MapSession> session;
+    std::shared_ptr<const Map> map; // session 이 읽는 공유 맵 (SharedMap 수명을 함께 유지)
+    MapRegistry* mapRegistry = nullptr; // 있으면 새로 게시된 맵을 안전한 시점에 적용
+    uint64_t mapSnapshotVersion = 0;
     Player player;
+    std::unique_ptr<Navigator> navigator; // 가게/집 목적지 트리는 공유 맵의 것을 읽기만 함
+    SpeedMonitor speedMonitor;
+    DeadReckoning positionEstimator; // 체크포인트 사이 경로 위 위치 추정
     vector<Call*> availableCalls;
     Call* activeCall = nullptr;
     std::chrono::steady_clock::time_point gameStartTime;
@@ -591,12 +4032,60 @@ public:
     bool gameRunning = true;
     Node* lastKnownNode = nullptr;
     std::chrono::steady_clock::time_point lastDriveUpdateTime;
-
-    Game(string playerName) : player(playerName, nullptr) {
-        map.buildMap();
-        player.currentLocation = map.stores[0];
+    size_t startupDestinationCount = 0, startupSharedBytes = 0, startupSessionBytes = 0;
+
+    // registry 가 없으면 프로세스 공용 기본 맵(defaultSharedMap)을 사용
+    Game(string playerName, MapRegistry* registry = nullptr) : mapRegistry(registry), player(playerName, nullptr) {
+        std::shared_ptr<const SharedMap> initial;
+        if (mapRegistry) initial = mapRegistry->acquire(mapSnapshotVersion);
+        if (!initial) initial = defaultSharedMap();
+        bindMap(initial);
+        player.currentLocation = map->stores[0];
         lastKnownNode = player.currentLocation;
         lastDriveUpdateTime = std::chrono::steady_clock::now();
+        // 시작 화면용 크기 (run 은 루프 스레드에서 돌고, 세션은 이벤트 스레드가 바꾸므로 미리 기록)
+        startupDestinationCount = session->sharedMap().trees().destinationCount();
+        startupSharedBytes = session->sharedMap().memoryBytes();
+        startupSessionBytes = session->memoryBytes();
+    }
+
+    // 맵 스냅샷 적용: 맵은 공유하고 이 게임의 세션 상태(신호, 탐색 공간, 길안내)만 새로 만듦
+    void bindMap(std::shared_ptr<const SharedMap> next) {
+        auto nextSession = std::make_shared<MapSession>(next);
+        nextSession->startTrafficLights();
+        map = std::shared_ptr<const Map>(next, &next->map());
+        navigator.reset(new Navigator(*map, &next->trees(), &nextSession->roadOverlay()));
+        std::atomic_store(&session, std::move(nextSession));
+        speedMonitor.setLimit(0);
+        positionEstimator.restart(-1, 0);
+    }
+
+    /**
+     * @brief 새로 게시된 맵이 있으면 적용 (진행 중인 배달이 없을 때만)
+     *
+     * 배달 중에는 콜의 가게/집 노드가 현재 스냅샷을 가리키므로 배달이 끝날 때까지 미룬다.
+     * 교체 후 이전 스냅샷은 게임 루프 스레드가 들고 있는 참조까지 사라지면 해제된다.
+     * 라이더 위치는 같은 ID + 같은 이름의 노드로 옮기고, 없으면 첫 가게에서 다시 시작.
+     * @return 새 맵을 적용했으면 true (이전 맵의 콜은 모두 폐기됨)
+     */
+    bool adoptLatestMap() {
+        if (!mapRegistry || activeCall || mapRegistry->version() == mapSnapshotVersion) return false;
+        std::shared_ptr<const SharedMap> next = mapRegistry->acquire(mapSnapshotVersion);
+        if (!next || &next->map() == map.get()) return false;
+        const Map& nextMap = next->map();
+        if (nextMap.stores.empty() || nextMap.houses.empty()) return false;
+
+        // 이전 맵의 노드는 bindMap 이후 해제될 수 있으므로 위치를 먼저 옮긴다
+        Node* at = player.currentLocation;
+        bool sameNode = at && at->id < (int)nextMap.nodes.size() && nextMap.nodes[at->id]->name == at->name;
+        player.currentLocation = sameNode ? nextMap.nodes[at->id] : nextMap.stores[0];
+        for (auto call : availableCalls) delete call; // 이전 맵의 노드를 가리키는 콜은 폐기
+        availableCalls.clear();
+        bindMap(next);
+        lastKnownNode = player.currentLocation;
+        cout << " [맵 교체] 맵 버전 " << mapSnapshotVersion << " 적용 (노드 " << map->nodes.size()
+            << ", 엣지 " << map->edges.size() << ", 남은 이전 스냅샷 " << mapRegistry->retiredAliveCount() << "개)\n";
+        return true;
     }
 
     ~Game() {
@@ -615,6 +4104,8 @@ public:
         cout << "=================================================\n";
         cout << "       배달의 전설 (운영 모듈) - " << player.name << " 님\n";
         cout << "       (5분 타이머 시작 / 하드웨어/앱 연동 대기 중...)\n";
+        cout << "       (목적지 " << startupDestinationCount << "곳 경로 트리는 처음 안내할 때 구성, 공유 맵 "
+            << startupSharedBytes / 1024.0 << " KB / 세션 " << startupSessionBytes / 1024.0 << " KB)\n";
         cout << "=================================================\n";
 
         while (gameRunning) {
@@ -623,7 +4114,7 @@ public:
                 gameRunning = false;
                 break;
             }
-            map.updateTrafficLights();
+            std::atomic_load(&session)->updateTrafficLights(); // 이번 틱 동안 스냅샷 유지
             std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 0.1초 틱
         }
         player.stats.score = player.totalRevenue - player.totalFines;
@@ -646,72 +4137,100 @@ public:
 
     // 새 콜 생성 (JSON 전송 로직 포함)
     void generateCalls() {
+        adoptLatestMap();
         updateCalls();
 
         string jsonOutput = "{";
         int callCount = 0;
 
-        while (availableCalls.size() < 3) {
-            Node* store = map.stores[std::uniform_int_distribution<>(0, 3)(rng)];
-            Node* house = map.houses[std::uniform_int_distribution<>(0, 5)(rng)];
+        // 지금 출발해 가게에 도착한 시각에 다시 집으로 출발 (신호 대기 반영)
+        // 플레이어 -> 모든 가게는 탐색 1회, 가게 -> 모든 집은 뽑힌 가게마다 탐색 1회
+        double departSec = session->signalClock();
+        vector<Route> toStores = session->findRoutesFrom(player.currentLocation, map->stores, departSec);
+        vector<vector<Route>> toHouses(map->stores.size());
+
+        const int MAX_ATTEMPTS = 100; // 갈 수 없는 조합만 남은 맵에서 무한 반복 방지
+        for (int attempt = 0; availableCalls.size() < 3 && attempt < MAX_ATTEMPTS; ++attempt) {
+            int storeIdx = std::uniform_int_distribution<>(0, (int)map->stores.size() - 1)(rng);
+            int houseIdx = std::uniform_int_distribution<>(0, (int)map->houses.size() - 1)(rng);
+            Node* store = map->stores[storeIdx];
+            Node* house = map->houses[houseIdx];
+            // 경로 탐색 전에 갈 수 없는 콜 제외 (일방통행으로 끊긴 구역)
+            if (!map->reachable(player.currentLocation, store) || !map->reachable(store, house)) continue;
+            if (toHouses[storeIdx].empty()) {
+                toHouses[storeIdx] = session->findRoutesFrom(store, map->houses, departSec + toStores[storeIdx].etaSec);
+            }
+            const Route& toStore = toStores[storeIdx];
+            const Route& toHouse = toHouses[storeIdx][houseIdx];
+            if (!toStore.found || !toHouse.found) continue; // 도로 통제로 끊긴 조합 (도달 가능 표는 통제 전 기준)
             int callId = (int)(std::chrono::steady_clock::now().time_since_epoch().count() % 10000);
             Call* newCall = new Call(callId, store, house, player.rating);
+            vector<Route> alternatives = session->findAlternativeRoutes(store, house, 3); // 배달 구간 대안 경로
 
-            vector<Edge*> pathToStore = map.findPath(player.currentLocation, store);
-            vector<Edge*> pathToHouse = map.findPath(store, house);
-
-            double distToStore = 0;
-            int lightsToStore = 0;
-            for (Edge* e : pathToStore) {
-                distToStore += e->length;
-                if (e->to->type == INTERSECTION) lightsToStore++;
-            }
-            double distToHouse = 0;
-            int lightsToHouse = 0;
-            for (Edge* e : pathToHouse) {
-                distToHouse += e->length;
-                if (e->to->type == INTERSECTION) lightsToHouse++;
-            }
-            double totalDist = distToStore + distToHouse;
-            int totalLights = lightsToStore + lightsToHouse;
+            double totalDist = toStore.distanceKm + toHouse.distanceKm;
+            int totalLights = toStore.lights + toHouse.lights;
+            double totalEta = toStore.etaSec + toHouse.etaSec;
 
             availableCalls.push_back(newCall);
             callCount++;
 
             // --- JSON 문자열 구성 
+            if (callCount > 1) jsonOutput += ", "; // 시도 횟수 제한으로 3개를 못 채워도 올바른 JSON 유지
             string callKey = "\"store" + std::to_string(callCount) + "\"";
             jsonOutput += callKey + ": {";
             jsonOutput += "\"id\": " + std::to_string(newCall->id) + ", ";
-            jsonOutput += "\"name\": \"" + newCall->store->name + "\", ";
+            jsonOutput += "\"name\": \"" + string(newCall->store->name) + "\", ";
             jsonOutput += "\"foodName\": \"" + newCall->foodName + "\", ";
-            jsonOutput += "\"destination\": \"" + newCall->house->name + "\", ";
+            jsonOutput += "\"destination\": \"" + string(newCall->house->name) + "\", ";
             jsonOutput += "\"price\": " + std::to_string((int)newCall->baseFee) + ", ";
             std::stringstream ss;
             ss << std::fixed << std::setprecision(1) << totalDist;
             jsonOutput += "\"distance\": " + ss.str() + ", ";
+            ss.str("");
+            ss << session->roadDistanceKm(store, house); // 가게 -> 집 최단 도로 거리 (기본 맵이면 표 조회)
+            jsonOutput += "\"deliveryKm\": " + ss.str() + ", ";
             jsonOutput += "\"lights\": " + std::to_string(totalLights) + ", ";
+            jsonOutput += "\"eta\": " + std::to_string((int)std::ceil(totalEta)) + ", ";
+            // 대안 경로: 가게 도착 시각에 출발한다고 보고 콜 eta 와 같은 시간 의존 모델로 다시 잰 eta + 지나는 노드 이름
+            // (캐시된 경로는 평균 신호 대기 기준이라 etaSec 를 그대로 보내면 콜 eta 와 어긋남)
+            jsonOutput += "\"alternatives\": [";
+            double houseDepartSec = departSec + toStore.etaSec;
+            for (size_t i = 0; i < alternatives.size(); ++i) {
+                double altEta = session->timeRouteSec(alternatives[i], houseDepartSec);
+                if (altEta == std::numeric_limits<double>::infinity()) continue; // 캐시 이후 통제된 도로 (안전장치)
+                std::stringstream alt;
+                alt << std::fixed << std::setprecision(1)
+                    << "{\"distance\": " << alternatives[i].distanceKm
+                    << ", \"lights\": " << alternatives[i].lights
+                    << ", \"eta\": " << (int)std::ceil(toStore.etaSec + altEta)
+                    << ", \"deliveryEta\": " << (int)std::ceil(altEta)
+                    << ", \"path\": [\"" << store->name << "\"";
+                for (int e : alternatives[i].edgeIds) alt << ", \"" << map->edges[e]->to->name << "\"";
+                alt << "]}";
+                jsonOutput += (jsonOutput.back() == '[' ? "" : ", ") + alt.str();
+            }
+            jsonOutput += "], ";
             jsonOutput += "\"isSpecial\": ";
             jsonOutput += (newCall->isSpecial ? "true" : "false");
             jsonOutput += ", ";
             jsonOutput += "\"expiresIn\": " + std::to_string(newCall->getRemainingTime());
             jsonOutput += "}";
 
-            if (availableCalls.size() < 3) {
-                jsonOutput += ", ";
-            }
-
             // --- 콘솔 로그 (테스트용) ---
             cout << " [새 콜 생성] " << (newCall->isSpecial ? "✨특수콜✨" : "일반콜") << "\n";
             cout << "   (ID: " << newCall->id << ") " << newCall->foodName << " (" << newCall->store->name << " -> " << newCall->house->name << ")\n";
             cout << "   (앱 전송 정보: 배달비 " << (int)newCall->baseFee
                 << "원, 총 거리 " << std::fixed << std::setprecision(1) << totalDist << "km"
-                << ", 신호 " << totalLights << "개)\n";
+                << ", 신호 " << totalLights << "개"
+                << ", 예상 소요 " << (int)std::ceil(totalEta) << "초"
+                << ", 배달 대안 경로 " << alternatives.size() << "개)\n";
         }
         jsonOutput += "}";
 
         // (통신) 3개의 콜 정보를 JSON으로 앱에 전송
         sendJsonToApp(jsonOutput);
         cout << " [통신] 3개의 콜 정보를 앱으로 전송했습니다.\n";
+        sendMetrics(); // 방금 콜 경로로 캐시를 썼으므로 플레이 중 적중률 갱신
     }
 
     // -----------------------------------------------------------------
@@ -742,8 +4261,11 @@ public:
             cout << "[콜 수락] ID: " << activeCall->id << "\n";
             cout << "   " << activeCall->store->name << " (으)로 이동하세요.\n";
 
-            string jsonMsg = "{\"status\":\"navigate_to_store\", \"storeName\":\"" + activeCall->store->name + "\"}";
+            string jsonMsg = "{\"status\":\"navigate_to_store\", \"storeName\":\"" + string(activeCall->store->name) + "\"}";
             sendJsonToApp(jsonMsg);
+            navigator->setDestination(player.currentLocation, activeCall->store);
+            sendNavigation("route");
+            updatePositionTracking(true);
 
             cout << " [알림] 선택한 콜 외의 나머지 콜을 목록에서 삭제합니다.\n";
             for (auto call : availableCalls) {
@@ -757,16 +4279,38 @@ public:
         }
     }
 
-    void OnNfcTagRead(string tagId) {
+    /**
+     * @param readAtSec 태그가 실제로 읽힌 시각 (session->signalClock() 기준, 음수면 지금)
+     *                  이벤트가 늦게 전달돼도 신호 위반은 이 시각의 신호로 판정
+     */
+    void OnNfcTagRead(std::string_view tagId, double readAtSec = -1) {
         if (!gameRunning) return;
+        if (adoptLatestMap()) generateCalls(); // 폐기된 콜 대신 새 맵에서 다시 생성
+        double enteredAt = readAtSec >= 0 ? readAtSec : session->signalClock();
 
-        Node* currentNode = map.getNodeByNfcTag(tagId);
+        Node* currentNode = map->getNodeByNfcTag(tagId);
         if (!currentNode) return;
 
+        Node* previousNode = lastKnownNode;
         player.currentLocation = currentNode;
         cout << "[NFC] 현위치: " << currentNode->name << endl;
         lastKnownNode = currentNode;
 
+        if (isWrongWay(previousNode, currentNode)) {
+            cout << " [역주행 감지] " << previousNode->name << " -> " << currentNode->name << " (일방통행 반대 방향)\n";
+            OnViolationDetected(WRONG_WAY);
+            return;
+        }
+        if (currentNode != previousNode && !session->wasGreenAt(currentNode, enteredAt)) {
+            cout << " [신호 위반 감지] " << currentNode->name << " 적색 신호에 진입\n";
+            OnViolationDetected(SIGNAL);
+        }
+
+        if (navigator->onCheckpoint(currentNode)) {
+            cout << " [길안내] 경로를 벗어나 " << navigator->target()->name << "까지 경로를 다시 찾았습니다.\n";
+            sendNavigation("reroute");
+        }
+
         if (activeCall && !player.currentFood) {
             if (currentNode == activeCall->store) {
                 // [수정] Player::pickupFood에 다음 목적지(집) 정보 전달
@@ -774,6 +4318,8 @@ public:
                     new Food(activeCall->foodType, activeCall->foodName),
                     activeCall->house
                 );
+                navigator->setDestination(currentNode, activeCall->house);
+                sendNavigation("route");
             }
         }
         else if (activeCall && player.currentFood) {
@@ -787,12 +4333,152 @@ public:
 
                 delete activeCall;
                 activeCall = nullptr;
+                navigator->clear();
                 sendJsonToApp("{\"status\":\"delivery_complete\", \"waiting_for_call\":true}");
 
                 cout << " [알림] 배달 완료! 새 배달 콜을 생성합니다.\n";
                 generateCalls();
             }
         }
+        updateSpeedLimit(currentNode);
+        updatePositionTracking(true);
+    }
+
+    /**
+     * @brief 연속된 두 체크포인트로 지나온 도로가 일방통행 역방향인지 판정
+     * from -> to 엣지가 없고 to -> from 일방통행 엣지만 있으면 역주행 (인접하지 않은 태그는 판정 안 함)
+     */
+    bool isWrongWay(const Node* from, const Node* to) {
+        if (!from || from == to || map->findEdge(from->id, to->id) >= 0) return false;
+        int reverse = map->findEdge(to->id, from->id);
+        return reverse >= 0 && map->edgeStore.oneWay[reverse];
+    }
+
+    /**
+     * @brief 체크포인트 이후 달리는 도로의 제한속도를 과속 판정에 반영
+     * 안내 경로가 있으면 경로의 다음 엣지, 없으면 나가는 도로 중 가장 높은 제한속도 (오판 방지)
+     */
+    void updateSpeedLimit(Node* at) {
+        int e = navigator->currentEdge();
+        if (e >= 0) {
+            speedMonitor.setLimit(map->edgeStore.speedLimit[e]);
+            return;
+        }
+        double limit = 0;
+        for (int i = map->outStart[at->id]; i < map->outStart[at->id + 1]; ++i) {
+            limit = std::max(limit, map->edgeStore.speedLimit[map->outEdgeIds[i]]);
+        }
+        speedMonitor.setLimit(limit);
+    }
+
+    /**
+     * @brief 위치 추정을 안내 경로의 현재 엣지에 맞춤
+     * @param atCheckpoint true 면 엣지 시작점에서 다시 시작, false 면 (재탐색) 같은 엣지일 때 진행 거리 유지
+     */
+    void updatePositionTracking(bool atCheckpoint) {
+        int e = navigator->currentEdge();
+        double lengthKm = e >= 0 ? map->edgeStore.length[e] : 0.0;
+        if (atCheckpoint) positionEstimator.restart(e, lengthKm);
+        else positionEstimator.follow(e, lengthKm);
+    }
+
+    // (통신) 체크포인트 사이 추정 위치 + 남은 예상 시간을 앱으로 전송
+    void sendPositionEstimate() {
+        int e = positionEstimator.currentEdge();
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3)
+            << "{\"status\":\"position\", \"from\":\"" << map->edges[e]->from->name << "\", \"to\":\""
+            << map->edges[e]->to->name << "\", \"progress\": " << positionEstimator.edgeFraction()
+            << ", \"km\": " << positionEstimator.distanceOnEdgeKm()
+            << ", \"eta\": " << (int)std::ceil(navigator->etaFrom(positionEstimator.edgeFraction())) << "}";
+        sendJsonToApp(ss.str());
+    }
+
+    // (통신) 현재 길안내 경로를 앱으로 전송 (status: route = 새 목적지, reroute = 경로 이탈)
+    void sendNavigation(const string& status) {
+        const Route& r = navigator->route();
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1)
+            << "{\"status\":\"" << status << "\", \"destination\":\"" << navigator->target()->name << "\", "
+            << "\"found\": " << (r.found ? "true" : "false") << ", "
+            << "\"distance\": " << r.distanceKm << ", \"lights\": " << r.lights << ", "
+            << "\"eta\": " << (int)std::ceil(r.etaSec) << ", \"path\": [";
+        if (r.found) {
+            ss << "\"" << player.currentLocation->name << "\"";
+            for (int e : r.edgeIds) ss << ", \"" << map->edges[e]->to->name << "\"";
+        }
+        ss << "]}";
+        sendJsonToApp(ss.str());
+    }
+
+    // 운영 지표 (세션 메모리, 경로 캐시 적중/미스) 출력 + 앱 전송 (콜 생성 때마다, 'p' 입력, 게임 종료 시)
+    // 캐시와 탐색 공간은 이벤트 스레드(콜 생성, NFC 처리)만 쓰므로 그 스레드에서 호출 (게임 루프 스레드 X)
+    void sendMetrics() {
+        RouteCacheStats cache = session->routeCacheStats();
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3)
+            << "{\"metrics\": {\"sessionBytes\": " << session->memoryBytes()
+            << ", \"routeCache\": {\"hits\": " << cache.hits << ", \"misses\": " << cache.misses
+            << ", \"hitRate\": " << cache.hitRate() << ", \"entries\": " << cache.entries
+            << ", \"evictions\": " << cache.evictions << ", \"invalidations\": " << cache.invalidations
+            << ", \"edgeInvalidations\": " << cache.edgeInvalidations << "}}}";
+        sendJsonToApp(ss.str());
+        cout << " [지표] 경로 캐시 적중 " << cache.hits << "회 / 미스 " << cache.misses << "회 (항목 "
+            << cache.entries << "/" << cache.capacity << ", 교체 " << cache.evictions << ", 전체 무효화 " << cache.invalidations
+            << ", 도로 통제로 버린 항목 " << cache.edgeInvalidations << ")\n";
+    }
+
+    /**
+     * @brief 도로 통제/혼잡 이벤트 (예: "I1-I2 혼잡" = OnRoadEvent(I1, I2, 2.0))
+     * 이 게임의 세션 오버레이만 바꾸며 맵은 다시 만들지 않는다. 안내 중인 경로가 바뀌면 재안내.
+     * @param timeFactor 0 이하면 통행 금지, 1 이면 해제, 그 밖에는 소요 시간 배율
+     */
+    void OnRoadEvent(int fromId, int toId, double timeFactor) {
+        if (fromId < 0 || toId < 0 || fromId >= (int)map->nodes.size() || toId >= (int)map->nodes.size()
+            || session->setRoadCondition(fromId, toId, timeFactor) == 0) {
+            std::cerr << "[Map Error] No road between node " << fromId << " and " << toId << endl;
+            return;
+        }
+        std::stringstream ss;
+        ss << "{\"roadEvent\":\"" << (timeFactor <= 0 ? "closed" : timeFactor == 1.0 ? "cleared" : "congested")
+            << "\", \"from\":\"" << map->nodes[fromId]->name << "\", \"to\":\"" << map->nodes[toId]->name
+            << "\", \"factor\":" << std::max(timeFactor, 0.0) << "}";
+        sendJsonToApp(ss.str());
+        cout << " [도로 상황] " << map->nodes[fromId]->name << " - " << map->nodes[toId]->name << ": "
+            << (timeFactor <= 0 ? "통제" : timeFactor == 1.0 ? "정상" : "혼잡") << "\n";
+        onRoadConditionChanged();
+    }
+
+    // 노드 통제 (예: "ST1 통제" = OnNodeClosed(ST1, true))
+    void OnNodeClosed(int nodeId, bool closed) {
+        if (nodeId < 0 || nodeId >= (int)map->nodes.size()) {
+            std::cerr << "[Map Error] Node ID " << nodeId << " is out of bounds." << endl;
+            return;
+        }
+        session->setNodeClosed(nodeId, closed);
+        sendJsonToApp(string("{\"roadEvent\":\"") + (closed ? "closed" : "cleared") + "\", \"node\":\""
+            + string(map->nodes[nodeId]->name) + "\"}");
+        cout << " [도로 상황] " << map->nodes[nodeId]->name << (closed ? " 통제" : " 통제 해제") << "\n";
+        onRoadConditionChanged();
+    }
+
+    // 안내 중이면 바뀐 도로 상황으로 경로 확인 (경로가 그대로면 바뀐 예상 시간만 전송)
+    void onRoadConditionChanged() {
+        if (!navigator->active()) return;
+        double etaBefore = navigator->route().etaSec;
+        if (navigator->onOverlayChanged(player.currentLocation)) {
+            if (navigator->route().found) {
+                cout << " [길안내] 도로 상황이 바뀌어 " << navigator->target()->name << "까지 경로를 다시 찾았습니다.\n";
+            }
+            else {
+                cout << " [길안내] 도로 통제로 " << navigator->target()->name << "까지 갈 수 있는 경로가 없습니다.\n";
+            }
+            sendNavigation("reroute");
+            updatePositionTracking(false);
+        }
+        else if (navigator->route().etaSec != etaBefore) {
+            sendNavigation("eta");
+        }
     }
 
     void OnViolationDetected(ViolationType type) {
@@ -819,23 +4505,715 @@ public:
     }
 
     void OnDrivingDataUpdate(double currentSpeed, double accelChange, double cornerSpeed) {
-        if (!gameRunning || !player.currentFood) return;
+        if (!gameRunning) return;
 
         auto now = std::chrono::steady_clock::now();
         auto dt = std::chrono::duration_cast<std::chrono::duration<double>>(now - lastDriveUpdateTime);
         double dt_sec = dt.count();
-
-        player.currentFood->degradeQuality(dt_sec, accelChange, cornerSpeed);
         lastDriveUpdateTime = now;
+
+        // 과속은 음식 유무와 관계없이 판정
+        if (speedMonitor.onSample(currentSpeed, dt_sec)) {
+            cout << " [과속 감지] " << (int)currentSpeed << "km/h (제한 " << (int)speedMonitor.currentLimit() << "km/h)\n";
+            OnViolationDetected(SPEED);
+        }
+
+        if (player.currentFood) {
+            player.currentFood->degradeQuality(dt_sec, accelChange, cornerSpeed);
+        }
+
+        // 체크포인트 사이 위치 추정 (전송 간격 제한)
+        if (positionEstimator.onSample(currentSpeed, dt_sec)) sendPositionEstimate();
+    }
+};
+
+
+// =================================================================
+// 7. 벤치마크 / 도구 모드 (명령행 인자로 실행)
+// =================================================================
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// 1M 엣지 맵: 바이너리 파일 매핑(mmap) 시작 시간 vs 게임용 Map 구성 시간
+void benchMapLoad() {
+    const string path = "bench_map.dmap";
+    const int side = 500; // 500 x 500 격자 -> 단방향 엣지 약 100만 개
+    {
+        Map source;
+        generateMap(source, MapGenConfig::grid(side, side));
+        auto t0 = std::chrono::steady_clock::now();
+        if (!writeMapFile(source, path)) return;
+        cout << "[bench] 맵 파일 작성: 노드 " << source.nodes.size() << ", 엣지 " << source.edges.size()
+            << " (" << std::fixed << std::setprecision(1) << elapsedMs(t0) << " ms)\n";
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    MapFile file;
+    if (!file.open(path)) return;
+    double openMs = elapsedMs(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    int nodeId = file.findNodeByTag("NFC_123456");
+    double tagUs = elapsedMs(t0) * 1000.0;
+
+    t0 = std::chrono::steady_clock::now();
+    vector<uint32_t> path1 = file.findPath(0, (uint32_t)(side * side - 1));
+    double pathMs = elapsedMs(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    {
+        Map loaded;
+        loaded.loadFromFile(file);
     }
+    double materializeMs = elapsedMs(t0);
+
+    cout << std::fixed << std::setprecision(3);
+    cout << "[bench] mmap 시작 (open + 검증): " << openMs << " ms\n";
+    cout << "[bench] NFC 태그 조회 (매핑 상태): " << tagUs << " us -> 노드 " << nodeId << "\n";
+    cout << "[bench] 최단 경로 (매핑 상태, 모서리 -> 모서리): " << pathMs << " ms, 엣지 " << path1.size() << "개\n";
+    cout << "[bench] 비교: 게임용 Map 객체로 구성 + 해제: " << materializeMs << " ms\n";
+    file.close();
+    std::remove(path.c_str());
+}
+
+// NFC 태그 10만 개: 기존 std::map (count + at) vs 완전 해시 표 조회
+// 끝자리만 다른 연속 태그(NFC_0 ~ NFC_n-1)로도 표가 구성되는지 먼저 확인 (실패 시 false)
+bool benchNfcLookup() {
+    for (int n : { 100, 1000, 10000, 100000 }) {
+        map<string, Node*, std::less<>> tags;
+        for (int i = 0; i < n; ++i) tags["NFC_" + std::to_string(i)] = nullptr;
+        NfcTagIndex index;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!index.build(tags) || index.size() != tags.size()) {
+            std::cerr << "[bench] FAIL: 연속 태그 NFC_0 ~ NFC_" << n - 1 << " 완전 해시 구성 실패 (std::map 조회로 대체됨)" << endl;
+            return false;
+        }
+        for (const auto& kv : tags) {
+            if (index.find(kv.first) != kv.second || index.find(kv.first + "x") != nullptr) {
+                std::cerr << "[bench] FAIL: 연속 태그 " << kv.first << " 조회 결과 불일치" << endl;
+                return false;
+            }
+        }
+        cout << std::fixed << std::setprecision(2);
+        cout << "[bench] 연속 태그 " << n << "개 완전 해시 구성: " << elapsedMs(t0) << " ms (조회 확인 포함)\n";
+    }
+
+    const int TAG_COUNT = 100000;
+    const int QUERY_COUNT = 2000000;
+    Map m;
+    m.nodes.reserve(TAG_COUNT);
+    for (int i = 0; i < TAG_COUNT; ++i) {
+        m.addNode("N" + std::to_string(i), STREET);
+        m.addNfcTag("NFC_" + std::to_string(1000000 + i * 7), i);
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    m.buildNfcIndex();
+    double buildMs = elapsedMs(t0);
+
+    std::mt19937 gen(42);
+    vector<string> queries(QUERY_COUNT);
+    for (auto& q : queries) q = "NFC_" + std::to_string(1000000 + (gen() % TAG_COUNT) * 7);
+
+    long long checksum = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (const string& q : queries) {
+        if (m.nfcTagMap.count(q)) checksum += m.nfcTagMap.at(q)->id;
+    }
+    double mapNs = elapsedMs(t0) * 1e6 / QUERY_COUNT;
+
+    t0 = std::chrono::steady_clock::now();
+    for (const string& q : queries) {
+        if (Node* n = m.nfcIndex.find(q)) checksum -= n->id;
+    }
+    double indexNs = elapsedMs(t0) * 1e6 / QUERY_COUNT;
+
+    cout << std::fixed << std::setprecision(1);
+    cout << "[bench] 태그 " << TAG_COUNT << "개 완전 해시 구성: " << buildMs << " ms\n";
+    cout << "[bench] std::map count+at: " << mapNs << " ns/조회\n";
+    cout << "[bench] NfcTagIndex     : " << indexNs << " ns/조회 (checksum " << checksum << ")\n";
+    return !m.nfcIndex.empty();
+}
+
+/**
+ * @brief 하드웨어 캐시 미스 카운터 (Linux perf 이벤트, 그 외 환경에서는 측정 불가로 표시)
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    long long stop() {
+        long long count = -1;
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
 };
 
+// 대형 격자 맵 구성/해제 시간 (아레나 vs 객체별 new/delete) + findPath 캐시 미스
+void benchArena() {
+    const int side = 700; // 49만 노드, 단방향 엣지 약 196만 개
+    auto t0 = std::chrono::steady_clock::now();
+    Map* m = new Map();
+    generateMap(*m, MapGenConfig::grid(side, side));
+    double buildMs = elapsedMs(t0);
+    size_t nodeCount = m->nodes.size(), edgeCount = m->edges.size();
+
+    CacheMissCounter misses;
+    t0 = std::chrono::steady_clock::now();
+    misses.start();
+    vector<Edge*> path = m->findPath(m->nodes[0], m->nodes[nodeCount - 1]);
+    long long missCount = misses.stop();
+    double pathMs = elapsedMs(t0);
+
+    cout << std::fixed << std::setprecision(1);
+    cout << "[bench] 격자 맵 구성: 노드 " << nodeCount << ", 엣지 " << edgeCount << " -> " << buildMs << " ms"
+        << " (아레나 " << m->arena.bytesUsed() / 1024 << " KB, 블록 " << m->arena.blockCount() << "개)\n";
+
+    t0 = std::chrono::steady_clock::now();
+    delete m;
+    cout << "[bench] 맵 해제 (인접 리스트, 태그 표 포함): " << elapsedMs(t0) << " ms\n";
+
+    // 같은 수의 Node/Edge/이름만 따로 할당/해제: 아레나 vs 객체별 new/delete
+    t0 = std::chrono::steady_clock::now();
+    {
+        MonotonicArena arena;
+        vector<Node*> arenaNodes(nodeCount);
+        for (size_t i = 0; i < nodeCount; ++i) {
+            arenaNodes[i] = arena.create<Node>((int)i, arena.copyString("N" + std::to_string(i)), STREET);
+        }
+        for (size_t i = 0; i < edgeCount; ++i) {
+            arena.create<Edge>((int)i, arenaNodes[i % nodeCount], arenaNodes[(i * 7) % nodeCount], 0.1, 50.0);
+        }
+        cout << "[bench] 객체만 할당 - 아레나: " << elapsedMs(t0) << " ms";
+        t0 = std::chrono::steady_clock::now();
+    }
+    cout << ", 해제 " << elapsedMs(t0) << " ms\n";
+
+    t0 = std::chrono::steady_clock::now();
+    vector<Node*> heapNodes(nodeCount);
+    vector<string*> heapNames(nodeCount);
+    vector<Edge*> heapEdges(edgeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        heapNames[i] = new string("N" + std::to_string(i));
+        heapNodes[i] = new Node((int)i, *heapNames[i], STREET);
+    }
+    for (size_t i = 0; i < edgeCount; ++i) {
+        heapEdges[i] = new Edge((int)i, heapNodes[i % nodeCount], heapNodes[(i * 7) % nodeCount], 0.1, 50.0);
+    }
+    cout << "[bench] 객체만 할당 - 객체별 new: " << elapsedMs(t0) << " ms";
+    t0 = std::chrono::steady_clock::now();
+    for (Edge* e : heapEdges) delete e;
+    for (Node* n : heapNodes) delete n;
+    for (string* name : heapNames) delete name;
+    cout << ", 해제 " << elapsedMs(t0) << " ms\n";
+
+    cout << "[bench] findPath (모서리 -> 모서리): " << pathMs << " ms, 엣지 " << path.size() << "개, 캐시 미스 ";
+    if (missCount >= 0) cout << missCount << "\n";
+    else cout << "측정 불가 (perf 이벤트 사용 불가 환경)\n";
+}
+
+// 대형 격자 맵 점대점 질의: 단방향 vs 양방향 다익스트라
+void benchBidirectional() {
+    const int side = 700;
+    const int QUERY_COUNT = 40;
+    Map m;
+    generateMap(m, MapGenConfig::grid(side, side));
+    m.buildRoutingIndex();
+
+    // 도시 안 배달 거리 수준: 출발지 주변 +-100 칸 안의 도착지
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> pick(0, side - 1), offset(-100, 100);
+    vector<std::pair<int, int>> queries(QUERY_COUNT);
+    for (auto& q : queries) {
+        int r = pick(gen), c = pick(gen);
+        int r2 = std::min(side - 1, std::max(0, r + offset(gen)));
+        int c2 = std::min(side - 1, std::max(0, c + offset(gen)));
+        q = { r * side + c, r2 * side + c2 };
+    }
+
+    const vector<double>& w = m.edgeWeights[METRIC_DISTANCE];
+    auto lengthOf = [&](const vector<int>& path) {
+        double total = 0;
+        for (int e : path) total += w[e];
+        return total;
+    };
+
+    double forwardMs = 0, bidirMs = 0;
+    int mismatches = 0;
+    for (const auto& q : queries) {
+        auto t0 = std::chrono::steady_clock::now();
+        vector<int> p1 = m.findPathIdsForward(m.scratch, q.first, q.second, w);
+        forwardMs += elapsedMs(t0);
+        t0 = std::chrono::steady_clock::now();
+        vector<int> p2 = m.findPathIdsBidirectional(m.scratch, q.first, q.second, w);
+        bidirMs += elapsedMs(t0);
+        if (std::abs(lengthOf(p1) - lengthOf(p2)) > 1e-9) mismatches++;
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 격자 " << side << "x" << side << ", 점대점 질의 " << QUERY_COUNT << "회 (반경 100칸)\n";
+    cout << "[bench] 단방향: " << forwardMs / QUERY_COUNT << " ms/질의\n";
+    cout << "[bench] 양방향: " << bidirMs / QUERY_COUNT << " ms/질의 (x" << forwardMs / bidirMs
+        << ", 거리 불일치 " << mismatches << "건)\n";
+}
+
+// 가게 x 집 ETA/거리 표: 스레드 수별 처리량
+void benchRouteMatrix() {
+    const int side = 300;
+    Map m;
+    generateMap(m, MapGenConfig::grid(side, side));
+    vector<Node*> sources(m.stores.begin(), m.stores.begin() + std::min<size_t>(128, m.stores.size()));
+    cout << "[bench] 격자 " << side << "x" << side << ", 가게 " << sources.size() << " x 집 " << m.houses.size() << " 표\n";
+
+    int maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    double baseMs = 0;
+    float checksum = 0;
+    for (int threads : threadCounts) {
+        RouteMatrixEngine engine(m, threads);
+        auto t0 = std::chrono::steady_clock::now();
+        RouteMatrix matrix = engine.compute(sources, m.houses, 0.0);
+        double ms = elapsedMs(t0);
+        if (threads == 1) baseMs = ms;
+        checksum = matrix.eta(0, 0) + matrix.distance(matrix.rowCount() - 1, matrix.colCount() - 1);
+        cout << std::fixed << std::setprecision(1);
+        cout << "[bench] 스레드 " << threads << ": " << ms << " ms (" << sources.size() * 1000.0 / ms
+            << " 출발지/초, x" << std::setprecision(2) << baseMs / ms << ")\n";
+    }
+    cout << "[bench] (하드웨어 스레드 " << maxThreads << "개, checksum " << checksum << ")\n";
+}
+
+// 대안 경로 3개 (Yen) 계산 시간
+void benchAlternatives() {
+    const int side = 300;
+    const int QUERY_COUNT = 30;
+    Map m;
+    generateMap(m, MapGenConfig::grid(side, side));
+    m.buildRoutingIndex();
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> pick(0, side - 1), offset(-30, 30);
+
+    double totalMs = 0;
+    size_t routes = 0;
+    for (int q = 0; q < QUERY_COUNT; ++q) {
+        int r = pick(gen), c = pick(gen);
+        int r2 = std::min(side - 1, std::max(0, r + offset(gen)));
+        int c2 = std::min(side - 1, std::max(0, c + offset(gen)));
+        auto t0 = std::chrono::steady_clock::now();
+        routes += m.findAlternativeRoutes(m.nodes[r * side + c], m.nodes[r2 * side + c2], 3).size();
+        totalMs += elapsedMs(t0);
+    }
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 격자 " << side << "x" << side << ", 반경 30칸 질의 " << QUERY_COUNT << "회, 경로 3개씩: "
+        << totalMs / QUERY_COUNT << " ms/질의 (경로 " << routes << "개)\n";
+}
+
+// 가게/집 목적지 트리 전체 구성 시간 + 메모리, 트리 조회 vs 매번 탐색
+void benchDestinationTrees() {
+    const int side = 100;
+    const int QUERY_COUNT = 2000;
+    Map m;
+    generateMap(m, MapGenConfig::grid(side, side));
+    m.buildRoutingIndex();
+    DestinationTreeCache cache(m);
+
+    auto t0 = std::chrono::steady_clock::now();
+    cache.buildAll();
+    double buildMs = elapsedMs(t0);
+
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> pickNode(0, (int)m.nodes.size() - 1);
+    std::uniform_int_distribution<int> pickHouse(0, (int)m.houses.size() - 1);
+    vector<std::pair<int, int>> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) queries.push_back({ pickNode(gen), m.houses[pickHouse(gen)]->id });
+
+    double sink = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (const auto& q : queries) sink += cache.costTo(m.nodes[q.first], m.nodes[q.second]);
+    double lookupMs = elapsedMs(t0);
+    t0 = std::chrono::steady_clock::now();
+    for (const auto& q : queries) sink += m.findPath(m.nodes[q.first], m.nodes[q.second], METRIC_LIGHT_AWARE).size();
+    double searchMs = elapsedMs(t0);
+
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 격자 " << side << "x" << side << ", 목적지 트리 " << cache.treeCount() << "개 구성: "
+        << buildMs << " ms, 메모리 " << cache.memoryBytes() / (1024.0 * 1024.0) << " MB\n";
+    cout << "[bench] 목적지까지 비용 " << QUERY_COUNT << "회: 트리 조회 " << lookupMs * 1000.0 / QUERY_COUNT
+        << " us/회, 매번 탐색 " << searchMs * 1000.0 / QUERY_COUNT << " us/회 (" << (sink > 0 ? "ok" : "-") << ")\n";
+}
+
+// 생성 맵 규모별 (10^3 ~ maxNodes): 생성 시간, 점대점 경로, 한 지점 -> 모든 가게 (콜 생성 1회분)
+void benchScale(int maxNodes) {
+    cout << std::fixed << std::setprecision(1);
+    for (int n = 1000; n <= maxNodes; n *= 10) {
+        MapGenConfig cfg;
+        cfg.layout = MapGenConfig::ORGANIC;
+        cfg.nodeCount = n;
+        cfg.roadCount = (size_t)n * 5 / 2; // 노드당 평균 도로 5개 (양 끝 기준)
+        cfg.withNfcTags = false;
+
+        Map m;
+        auto t0 = std::chrono::steady_clock::now();
+        generateMap(m, cfg);
+        double genMs = elapsedMs(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        vector<Edge*> path = m.findPath(m.nodes[0], m.nodes[n - 1], METRIC_LIGHT_AWARE);
+        double pathMs = elapsedMs(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        vector<Route> toStores = m.findRoutesFrom(m.nodes[n / 2], m.stores, 0.0);
+        double callMs = elapsedMs(t0);
+
+        cout << "[bench] 노드 " << n << ", 엣지 " << m.edges.size() << ", 가게 " << m.stores.size()
+            << ": 생성 " << genMs << " ms, 경로 " << pathMs << " ms (엣지 " << path.size() << "개)"
+            << ", 가게 경로 " << callMs << " ms\n";
+    }
+}
+
+// 생성 맵 점대점 질의: 이진 힙(double 가중치) vs radix heap(정수 가중치)
+void benchRadixHeap() {
+    const int side = 500;
+    const int QUERY_COUNT = 40;
+    MapGenConfig cfg = MapGenConfig::grid(side, side, 3);
+    cfg.layout = MapGenConfig::ORGANIC;
+    cfg.roadCount = (size_t)side * side * 5 / 2;
+    cfg.withNfcTags = false;
+    Map m;
+    generateMap(m, cfg);
+    m.buildRoutingIndex();
+
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> pick(0, side - 1), offset(-150, 150);
+    const RouteMetric metrics[] = { METRIC_DISTANCE, METRIC_LIGHT_AWARE };
+    const char* metricNames[] = { "거리(m)", "신호 대기 포함 시간(0.1초)" };
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 생성 맵 " << side << "x" << side << " (노드 " << m.nodes.size() << ", 엣지 " << m.edges.size()
+        << "), 점대점 질의 " << QUERY_COUNT << "회 (반경 150칸)\n";
+
+    for (int k = 0; k < 2; ++k) {
+        const vector<double>& w = m.edgeWeights[metrics[k]];
+        auto costOf = [&](const vector<int>& path) {
+            double total = 0;
+            for (int e : path) total += w[e];
+            return total;
+        };
+        double heapMs = 0, radixMs = 0, worstGap = 0;
+        for (int q = 0; q < QUERY_COUNT; ++q) {
+            int r = pick(gen), c = pick(gen);
+            int r2 = std::min(side - 1, std::max(0, r + offset(gen)));
+            int c2 = std::min(side - 1, std::max(0, c + offset(gen)));
+            int a = r * side + c, b = r2 * side + c2;
+            auto t0 = std::chrono::steady_clock::now();
+            vector<int> p1 = m.findPathIdsForward(m.scratch, a, b, w);
+            heapMs += elapsedMs(t0);
+            t0 = std::chrono::steady_clock::now();
+            vector<int> p2 = m.findPathIdsRadix(m.scratch, a, b, m.edgeWeightsInt[metrics[k]]);
+            radixMs += elapsedMs(t0);
+            if (!p1.empty()) worstGap = std::max(worstGap, costOf(p2) / costOf(p1) - 1.0);
+        }
+        cout << "[bench] " << metricNames[k] << ": 이진 힙 " << heapMs / QUERY_COUNT << " ms/질의, radix heap "
+            << radixMs / QUERY_COUNT << " ms/질의 (x" << heapMs / radixMs << ", 반올림으로 인한 최대 비용 차이 "
+            << worstGap * 100.0 << "%)\n";
+    }
+}
+
+// 동시 게임 세션 수별 맵 메모리: 공유 맵 한 벌 + 세션 상태 (측정) vs 세션마다 맵을 따로 만들 때 (추정, 만들지 않고 곱셈)
+void benchSessions() {
+    const int counts[] = { 1, 100, 10000 };
+    MapRegistry registry;
+    {
+        auto m = std::make_shared<Map>();
+        m->buildMap();
+        registry.publish(m);
+    }
+    uint64_t version;
+    std::shared_ptr<const SharedMap> shared = registry.acquire(version);
+    const Map& map = shared->map();
+    for (const vector<Node*>* list : { &map.stores, &map.houses }) {
+        for (const Node* n : *list) shared->trees().find(n); // 목적지 트리를 모두 채운 상태 기준
+    }
+    size_t sharedBytes = shared->memoryBytes();
+
+    cout << std::fixed << std::setprecision(1);
+    cout << "[bench] 기본 맵 (노드 " << map.nodes.size() << ", 엣지 " << map.edges.size() << "), 공유 맵 "
+        << sharedBytes / 1024.0 << " KB (목적지 트리 " << shared->trees().memoryBytes() / 1024.0 << " KB 포함)\n";
+    for (int count : counts) {
+        vector<std::unique_ptr<Game>> games;
+        games.reserve(count);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) games.emplace_back(new Game("bench", &registry));
+        double createMs = elapsedMs(t0);
+
+        // 세션마다 콜 생성 1회분 탐색 + 길안내 1회 (작업 공간이 실제 크기까지 커진 상태로 측정)
+        size_t sessionBytes = 0;
+        for (auto& g : games) {
+            Node* store = map.stores[0];
+            g->session->findRoutesFrom(g->player.currentLocation, map.stores, 0.0);
+            g->session->findAlternativeRoutes(store, map.houses[0], 3);
+            g->navigator->setDestination(store, map.houses[0]);
+            sessionBytes += g->session->memoryBytes() + g->navigator->memoryBytes();
+        }
+        double perSession = (double)sessionBytes / count;
+        double sharedTotal = sharedBytes + (double)sessionBytes;
+        double ownedEstimate = (double)count * (sharedBytes + perSession); // 세션 수 x (공유 맵 + 세션)
+        cout << "[bench] 세션 " << count << "개: 세션당 " << perSession / 1024.0 << " KB, 총 "
+            << sharedTotal / 1024.0 << " KB (측정) / 세션마다 맵 소유 시 " << ownedEstimate / 1024.0
+            << " KB (추정: 세션 수 x (공유 맵 + 세션)), Game 생성 " << createMs * 1000.0 / count << " us/개 (측정)\n";
+    }
+}
+
+// 도로 통제/혼잡 이벤트 1건: 세션 오버레이 반영 시간, 그대로 쓸 수 있는 목적지 트리 수, 공유 맵 재구성과 비교
+void benchRoadEvents() {
+    const int side = 100;
+    const int EVENT_COUNT = 200;
+    auto generated = std::make_shared<Map>();
+    generateMap(*generated, MapGenConfig::grid(side, side));
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto shared = std::make_shared<const SharedMap>(generated); // 이벤트마다 맵을 고쳐 다시 게시하는 경우의 비용
+    double rebuildMs = elapsedMs(t0);
+    const Map& map = shared->map();
+    const DestinationTreeCache& trees = shared->trees();
+    MapSession session(shared);
+
+    t0 = std::chrono::steady_clock::now();
+    for (Node* d : map.houses) trees.find(d); // 처음 조회 때 구성 (이후 이벤트마다 재사용 여부만 확인)
+    double treeMs = elapsedMs(t0);
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> pickEdge(0, (int)map.edges.size() - 1);
+    vector<int> events;
+    for (int i = 0; i < EVENT_COUNT; ++i) events.push_back(pickEdge(gen));
+
+    t0 = std::chrono::steady_clock::now();
+    session.setRoadCondition(map.edgeStore.from[events[0]], map.edgeStore.to[events[0]], 2.0);
+    double firstUs = elapsedMs(t0) * 1000.0; // 가중치 배열 복사 포함
+    session.clearRoadConditions();
+
+    double applyMs = 0;
+    long long validTrees = 0;
+    for (int i = 0; i < EVENT_COUNT; ++i) {
+        int e = events[i];
+        t0 = std::chrono::steady_clock::now();
+        session.setRoadCondition(map.edgeStore.from[e], map.edgeStore.to[e], i % 2 ? 0.0 : 2.0);
+        applyMs += elapsedMs(t0);
+        for (Node* d : map.houses) {
+            const DestinationTree* t = trees.find(d);
+            if (t && trees.validUnder(*t, session.roadOverlay())) ++validTrees;
+        }
+        session.clearRoadConditions();
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 격자 " << side << "x" << side << " (엣지 " << map.edges.size() << "), 공유 맵 재구성 "
+        << rebuildMs << " ms, 집 목적지 트리 " << trees.treeCount() << "개 첫 조회 구성 " << treeMs << " ms\n";
+    cout << "[bench] 도로 이벤트 " << EVENT_COUNT << "건 (혼잡/통제 번갈아): 첫 이벤트 " << firstUs
+        << " us (가중치 복사 포함), 이후 " << applyMs * 1000.0 / EVENT_COUNT << " us/건\n";
+    cout << "[bench] 이벤트 1건 후 그대로 쓰는 집 목적지 트리: 평균 " << (double)validTrees / EVENT_COUNT << " / "
+        << map.houses.size() << "개\n";
+}
+
+// 콜 생성 패턴 (인기 가게 -> 집 조합 반복): 경로 캐시 적중률과 질의 시간, 캐시 없이 매번 탐색과 비교
+void benchRouteCache() {
+    const int side = 100;
+    const int HOT_STORES = 10, HOT_HOUSES = 30; // 조합 300개 > 캐시 용량 256 (교체도 측정)
+    const int QUERY_COUNT = 3000;
+    auto generated = std::make_shared<Map>();
+    generateMap(*generated, MapGenConfig::grid(side, side));
+    auto shared = std::make_shared<const SharedMap>(generated);
+    const Map& map = shared->map();
+    MapSession cached(shared);
+    SearchScratch uncached;
+
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> pickStore(0, HOT_STORES - 1), pickHouse(0, HOT_HOUSES - 1);
+    vector<std::pair<Node*, Node*>> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        // 앞쪽 조합일수록 자주 나오도록 (두 번 뽑아 작은 쪽)
+        int s = std::min(pickStore(gen), pickStore(gen)), h = std::min(pickHouse(gen), pickHouse(gen));
+        queries.push_back({ map.stores[s % map.stores.size()], map.houses[h % map.houses.size()] });
+    }
+
+    size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& q : queries) sink += cached.findAlternativeRoutes(q.first, q.second, 3).size();
+    double cachedMs = elapsedMs(t0);
+    t0 = std::chrono::steady_clock::now();
+    for (const auto& q : queries) sink += map.findAlternativeRoutes(uncached, q.first, q.second, 3).size();
+    double searchMs = elapsedMs(t0);
+
+    // 혼잡 1건은 그 도로를 지나는 항목만 버리고, 해제(엣지가 싸짐)는 전부 버림
+    // 남은 항목은 혼잡을 반영해 새로 찾은 결과와 같아야 함
+    RouteCacheStats before = cached.routeCacheStats();
+    vector<Route> hot = cached.findAlternativeRoutes(queries[0].first, queries[0].second, 3);
+    int congested = hot[0].edgeIds[hot[0].edgeIds.size() / 2];
+    cached.setRoadCondition(map.edgeStore.from[congested], map.edgeStore.to[congested], 2.0);
+    RouteCacheStats afterCongestion = cached.routeCacheStats();
+    size_t kept = afterCongestion.entries, mismatched = 0;
+    for (int s = 0; s < HOT_STORES; ++s) {
+        for (int h = 0; h < HOT_HOUSES; ++h) {
+            Node* a = map.stores[s % map.stores.size()];
+            Node* b = map.houses[h % map.houses.size()];
+            vector<Route> fromCache = cached.findAlternativeRoutes(a, b, 3);
+            uncached.overlay = &cached.roadOverlay();
+            vector<Route> fresh = map.findAlternativeRoutes(uncached, a, b, 3);
+            uncached.overlay = nullptr;
+            if (fromCache.size() != fresh.size()) ++mismatched;
+            else {
+                for (size_t i = 0; i < fresh.size(); ++i) mismatched += fresh[i].edgeIds != fromCache[i].edgeIds;
+            }
+        }
+    }
+    cached.clearRoadConditions();
+
+    RouteCacheStats stats = cached.routeCacheStats();
+    cout << std::fixed << std::setprecision(2);
+    cout << "[bench] 격자 " << side << "x" << side << ", 가게 " << HOT_STORES << " x 집 " << HOT_HOUSES << " 조합에서 대안 경로 "
+        << QUERY_COUNT << "회 (캐시 " << stats.capacity << "개)\n";
+    cout << "[bench] 캐시 사용 " << cachedMs * 1000.0 / QUERY_COUNT << " us/회 (적중률 " << before.hitRate() * 100.0
+        << "%, 교체 " << before.evictions << "), 매번 탐색 "
+        << searchMs * 1000.0 / QUERY_COUNT << " us/회, 세션 메모리 (캐시 포함) " << cached.memoryBytes() / 1024.0 << " KB ("
+        << (sink > 0 ? "ok" : "-") << ")\n";
+    cout << "[bench] 도로 혼잡 1건: 항목 " << before.entries << "개 중 " << afterCongestion.edgeInvalidations
+        << "개만 버리고 " << kept << "개 유지, 새로 찾은 결과와 다른 경로 " << mismatched << "개"
+        << (mismatched ? " (FAIL)" : "") << ", 해제 후 전체 무효화 " << stats.invalidations - before.invalidations << "회\n";
+}
+
+// 기본 맵 모든 노드 쌍 최단 도로 거리: 컴파일 시간 거리 표 조회 vs 거리 기준 탐색
+void benchDefaultDistances() {
+    const int ROUNDS = 200;
+    Map table;
+    table.buildMap();
+    Map searched;
+    searched.buildMap();
+    searched.addNode("bench", INTERSECTION); // 맵이 바뀐 것으로 표시 -> 표 대신 탐색 (기존 노드 간 거리는 같음)
+    searched.prepareIndexes();
+    const int n = DEFAULT_MAP_NODE_COUNT;
+
+    double sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) sink += table.roadDistanceKm(table.scratch, table.nodes[a], table.nodes[b]);
+        }
+    }
+    double tableMs = elapsedMs(t0);
+    t0 = std::chrono::steady_clock::now();
+    double maxDiff = 0;
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) {
+                double km = searched.roadDistanceKm(searched.scratch, searched.nodes[a], searched.nodes[b]);
+                if (r == 0) maxDiff = std::max(maxDiff, std::abs(km - DEFAULT_MAP_DISTANCE_KM[a][b]));
+                sink += km;
+            }
+        }
+    }
+    double searchMs = elapsedMs(t0);
+
+    long long lookups = (long long)ROUNDS * n * n;
+    cout << std::fixed << std::setprecision(3);
+    cout << "[bench] 기본 맵 " << n << "x" << n << " 쌍 x " << ROUNDS << "회: 거리 표 " << tableMs * 1e6 / lookups
+        << " ns/회, 탐색 " << searchMs * 1e6 / lookups << " ns/회, 최대 차이 " << maxDiff << " km ("
+        << (sink > 0 ? "ok" : "-") << ")\n";
+}
+
+/**
+ * @brief 명령행 도구 모드
+ *   --convert-map <입력 텍스트> <출력 .dmap>
+ *   --generate-map <grid|organic> <노드 수> <시드> <출력 .dmap>
+ *   --bench <mapload|nfc|arena|bidir|matrix|ksp|trees|radix|sessions|roads|routecache|defaultdist|scale [최대 노드 수]>
+ */
+int runToolMode(int argc, char* argv[]) {
+    string mode = argv[1];
+    if (mode == "--convert-map" && argc >= 4) {
+        std::ifstream in(argv[2]);
+        if (!in) {
+            std::cerr << "[Map Error] Cannot open " << argv[2] << endl;
+            return 1;
+        }
+        Map m;
+        if (!loadMapText(in, m) || !writeMapFile(m, argv[3])) return 1;
+        cout << "맵 변환 완료: 노드 " << m.nodes.size() << ", 엣지 " << m.edges.size()
+            << ", NFC 태그 " << m.nfcTagMap.size() << " -> " << argv[3] << "\n";
+        return 0;
+    }
+    if (mode == "--generate-map" && argc >= 6) {
+        MapGenConfig cfg;
+        cfg.layout = string(argv[2]) == "organic" ? MapGenConfig::ORGANIC : MapGenConfig::GRID;
+        cfg.nodeCount = std::atoi(argv[3]);
+        cfg.seed = std::strtoull(argv[4], nullptr, 10);
+        Map m;
+        if (!generateMap(m, cfg) || !writeMapFile(m, argv[5])) return 1;
+        cout << "맵 생성 완료: 노드 " << m.nodes.size() << ", 엣지 " << m.edges.size()
+            << ", 가게 " << m.stores.size() << ", 집 " << m.houses.size() << " -> " << argv[5] << "\n";
+        return 0;
+    }
+    if (mode == "--bench" && argc >= 3) {
+        string name = argv[2];
+        if (name == "mapload") { benchMapLoad(); return 0; }
+        if (name == "nfc") return benchNfcLookup() ? 0 : 1;
+        if (name == "arena") { benchArena(); return 0; }
+        if (name == "bidir") { benchBidirectional(); return 0; }
+        if (name == "matrix") { benchRouteMatrix(); return 0; }
+        if (name == "ksp") { benchAlternatives(); return 0; }
+        if (name == "trees") { benchDestinationTrees(); return 0; }
+        if (name == "radix") { benchRadixHeap(); return 0; }
+        if (name == "sessions") { benchSessions(); return 0; }
+        if (name == "roads") { benchRoadEvents(); return 0; }
+        if (name == "routecache") { benchRouteCache(); return 0; }
+        if (name == "defaultdist") { benchDefaultDistances(); return 0; }
+        if (name == "scale") { benchScale(argc >= 4 ? std::atoi(argv[3]) : 1000000); return 0; }
+    }
+    cout << "사용법: " << argv[0] << " [--convert-map <입력.txt> <출력.dmap> | --generate-map <grid|organic> <노드 수> <시드> <출력.dmap>"
+        << " | --bench <mapload|nfc|arena|bidir|matrix|ksp|trees|radix|sessions|roads|routecache|defaultdist|scale [최대 노드 수]>]\n";
+    return 1;
+}
+
 
 // =================================================================
-// 7. Main 함수 (테스트 환경)
+// 8. Main 함수 (테스트 환경)
 // =================================================================
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) return runToolMode(argc, argv);
+
     if (!db_init("scoreboard.db")) {
         std::cerr << "데이터베이스 초기화 실패!" << endl;
         return 1;
@@ -865,8 +5243,14 @@ int main() {
     cout << "[이름 확인] " << username << " 님. (앱으로 'Enter' 및 이름 전송)\n";
     sendJsonToApp("{\"username\":\"" + username + "\"}");
 
-    // 3. 게임 생성
-    Game game(username);
+    // 3. 게임 생성 (맵은 게시된 스냅샷 사용, 'm' 입력으로 default_map.txt 를 새 버전으로 게시)
+    MapRegistry maps;
+    {
+        auto initial = std::make_shared<Map>();
+        initial->buildMap();
+        maps.publish(initial);
+    }
+    Game game(username, &maps);
 
     // 4. 게임 루프를 별도 스레드에서 실행
     std::thread gameThread([&game]() {
@@ -878,7 +5262,7 @@ int main() {
 
     // 6. [테스트] 메인 스레드에서 가상 이벤트 주입
     cout << "\n[테스트 시뮬레이션 시작]\n";
-    cout << " (q: 종료, c: 콜 수락, n: NFC 태그, v: 위반)\n";
+    cout << " (q: 종료, c: 콜 수락, n: NFC 태그, v: 위반, m: 맵 다시 게시, x: 노드 통제 전환, j: 도로 혼잡, p: 운영 지표)\n";
 
     char testInput;
     while (game.gameRunning && cin >> testInput) {
@@ -902,6 +5286,35 @@ int main() {
                 cin >> tag;
                 game.OnNfcTagRead(tag);
             }
+            if (testInput == 'm') { // 'm' 맵 파일을 읽어 새 스냅샷으로 게시 (다음 콜 생성/NFC 때 적용)
+                std::ifstream in("default_map.txt");
+                auto next = std::make_shared<Map>();
+                if (in && loadMapText(in, *next)) {
+                    cout << " [테스트] 맵 버전 " << maps.publish(next) << " 게시 (배달이 없을 때 적용)\n";
+                }
+                else {
+                    cout << " [테스트] default_map.txt 를 읽을 수 없습니다.\n";
+                }
+            }
+            if (testInput == 'x') { // 'x' <tag_id_str> 태그 위치 노드 통제/해제 전환 (예: x NFC_ST1)
+                string tag;
+                cout << " [테스트] 통제할 노드의 NFC 태그: ";
+                cin >> tag;
+                if (Node* n = game.map->getNodeByNfcTag(tag)) {
+                    int e = game.map->inStart[n->id] < game.map->inStart[n->id + 1] ? game.map->inEdgeIds[game.map->inStart[n->id]] : -1;
+                    game.OnNodeClosed(n->id, e < 0 || !game.session->roadOverlay().isClosed(e));
+                }
+            }
+            if (testInput == 'j') { // 'j' <from> <to> <배율> 두 노드 사이 도로 혼잡 (0: 통제, 1: 정상)
+                int from, to;
+                double factor;
+                cout << " [테스트] 도로 양 끝 노드 ID와 소요 시간 배율: ";
+                cin >> from >> to >> factor;
+                game.OnRoadEvent(from, to, factor);
+            }
+            if (testInput == 'p') { // 'p' 운영 지표 (경로 캐시 적중/미스) 지금 보고
+                game.sendMetrics();
+            }
             if (testInput == 'v') { // 'v' <1,2,3> (Signal, Speed, WrongWay)
                 int vType;
                 cout << " [테스트] 위반 유형 (1:신호, 2:속도, 3:역주행): ";
@@ -924,6 +5337,7 @@ int main() {
     if (gameThread.joinable()) {
         gameThread.join();
     }
+    game.sendMetrics(); // 경로 캐시를 쓰는 이벤트 스레드에서 보고
 
     GameResult result = game.player.stats;
 